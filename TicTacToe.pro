@@ -2,4 +2,14 @@ TEMPLATE = subdirs
 
 SUBDIRS += \
     TicTacToeCore \
-    TicTacToeWidget
+    TicTacToeWidget \
+    TicTacToeReplay \
+    TicTacToeExport \
+    TicTacToeTournament \
+    TicTacToePerft
+
+TicTacToeWidget.depends = TicTacToeCore
+TicTacToeReplay.depends = TicTacToeCore
+TicTacToeExport.depends = TicTacToeCore
+TicTacToeTournament.depends = TicTacToeCore
+TicTacToePerft.depends = TicTacToeCore
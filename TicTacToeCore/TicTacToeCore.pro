@@ -8,6 +8,7 @@ QT       -= gui
 
 TARGET = TicTacToeCore
 TEMPLATE = lib
+CONFIG += c++17
 
 DEFINES += TICTACTOECORE_LIBRARY
 
@@ -17,6 +18,9 @@ DEFINES += TICTACTOECORE_LIBRARY
 # deprecated API in order to know how to port your code away from it.
 DEFINES += QT_DEPRECATED_WARNINGS
 
+# "qmake CONFIG+=tracing" compiles in the trace spans (see tictactoe_trace.hpp)
+CONFIG(tracing): DEFINES += TICTACTOE_ENABLE_TRACING
+
 # You can also make your code fail to compile if you use deprecated APIs.
 # In order to do so, uncomment the following line.
 # You can also select to disable deprecated APIs only up to a certain version of Qt.
@@ -24,12 +28,33 @@ DEFINES += QT_DEPRECATED_WARNINGS
 
 SOURCES += \
     tictactoe_game.cpp \
-    tictactoe_board.cpp
+    tictactoe_batch.cpp \
+    tictactoe_board.cpp \
+    tictactoe_cache.cpp \
+    tictactoe_evaluator.cpp \
+    tictactoe_parameters.cpp \
+    tictactoe_position.cpp \
+    tictactoe_search.cpp \
+    tictactoe_sparse_board.cpp \
+    tictactoe_trace.cpp
 
 HEADERS += \
         tictactoecore_global.hpp \ 
     tictactoe_game.hpp \
-    tictactoe_board.hpp
+    tictactoe_board.hpp \
+    tictactoe_batch.hpp \
+    tictactoe_cache.hpp \
+    tictactoe_evaluator.hpp \
+    tictactoe_memory.hpp \
+    tictactoe_parameters.hpp \
+    tictactoe_position.hpp \
+    tictactoe_search.hpp \
+    tictactoe_session.hpp \
+    tictactoe_sparse_board.hpp \
+    tictactoe_trace.hpp
+
+# shm_open lives in librt on older glibc
+unix:!macx: LIBS += -lrt
 
 unix {
     target.path = /usr/lib
@@ -0,0 +1,465 @@
+/// @file
+///
+/// @author
+///
+/// @copyright
+
+#include "tictactoe_batch.hpp"
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cstring>
+#include <numeric>
+#include <stdexcept>
+
+namespace tictactoe {
+
+namespace {
+
+constexpr uint8_t line_count = 2 * board_size + 2;
+constexpr uint8_t danger_zone = board_size - 1;
+
+///
+/// \brief The Line struct, a winning line and the moves updating its cells
+///
+struct Line {
+    std::array<uint8_t, board_size> cells;
+    CellMask mask;
+    /// The game updates a line after a move on one of its cells, except the second diagonal
+    /// after a move on the center: the first diagonal takes precedence there
+    CellMask touched_by;
+};
+
+constexpr std::array<Line, line_count> Lines()
+{
+    std::array<Line, line_count> lines{};
+    for (uint8_t i = 0; i < board_size; ++i) {
+        for (uint8_t j = 0; j < board_size; ++j) {
+            // Columns, then rows, then the diagonals
+            lines[i].cells[j] = static_cast<uint8_t>(j * board_size + i);
+            lines[board_size + i].cells[j] = static_cast<uint8_t>(i * board_size + j);
+        }
+        lines[2 * board_size].cells[i] = static_cast<uint8_t>(i * board_size + i);
+        lines[2 * board_size + 1].cells[i] =
+            static_cast<uint8_t>((board_size - 1 - i) * board_size + i);
+    }
+    for (auto& line : lines) {
+        for (auto cell : line.cells) {
+            line.mask |= static_cast<CellMask>(1u << cell);
+        }
+        line.touched_by = line.mask;
+    }
+    if (board_size % 2 == 1) {
+        auto center = board_size * board_size / 2;
+        lines[2 * board_size + 1].touched_by &= static_cast<CellMask>(~(1u << center));
+    }
+    return lines;
+}
+
+constexpr auto lines = Lines();
+
+#if defined(__GNUC__) || defined(__clang__)
+/// Lanes processed per kernel instruction
+constexpr size_t lane_block = 16;
+using Vec = uint8_t __attribute__((vector_size(lane_block)));
+
+inline Vec Splat(uint8_t value)
+{
+    return Vec{} + value;
+}
+
+inline Vec Eq(Vec a, Vec b)
+{
+    return reinterpret_cast<Vec>(a == b);
+}
+
+inline Vec Gt(Vec a, Vec b)
+{
+    return reinterpret_cast<Vec>(a > b);
+}
+
+inline bool Any(Vec v)
+{
+    uint64_t words[lane_block / sizeof(uint64_t)];
+    std::memcpy(words, &v, sizeof(words));
+    return (words[0] | words[1]) != 0;
+}
+#else
+constexpr size_t lane_block = 1;
+using Vec = uint8_t;
+
+inline Vec Splat(uint8_t value)
+{
+    return value;
+}
+
+inline Vec Eq(Vec a, Vec b)
+{
+    return a == b ? 0xff : 0;
+}
+
+inline Vec Gt(Vec a, Vec b)
+{
+    return a > b ? 0xff : 0;
+}
+
+inline bool Any(Vec v)
+{
+    return v != 0;
+}
+#endif
+
+inline Vec Load(const uint8_t* lanes)
+{
+    Vec v;
+    std::memcpy(&v, lanes, sizeof(v));
+    return v;
+}
+
+inline void Store(uint8_t* lanes, Vec v)
+{
+    std::memcpy(lanes, &v, sizeof(v));
+}
+
+/// mask ? a : b for each lane, mask lanes are 0xff or 0
+inline Vec Select(Vec mask, Vec a, Vec b)
+{
+    return static_cast<Vec>((mask & a) | (~mask & b));
+}
+
+/// Number of stones (0xff lanes) among three
+inline Vec Count(Vec a, Vec b, Vec c)
+{
+    return static_cast<Vec>((a & Splat(1)) + (b & Splat(1)) + (c & Splat(1)));
+}
+
+///
+/// \brief The PointLanes class, ConfiguredGamePolicy point updates on a block of lanes
+///
+class PointLanes {
+public:
+    explicit PointLanes(const PolicyParameters& parameters)
+        : m_win_attack{Splat(parameters.win_attack_points)}
+        , m_win_attack_increment{parameters.win_attack_increment}
+        , m_increment_limit{Splat(static_cast<uint8_t>(max_points - parameters.win_attack_points))}
+        , m_attack_decay{Splat(parameters.attack_decay)}
+        , m_defense{Splat(static_cast<uint8_t>(
+              std::min<int>(parameters.defense_points + parameters.defense_per_enemy, max_points)))}
+        , m_danger_defense{Splat(parameters.danger_defense_points)}
+    {
+    }
+
+    Vec Attack(Vec enemy_count, Vec friendly_count, Vec points) const
+    {
+        // Increments stop at max_points, decays at 0
+        auto win = m_win_attack_increment
+                       ? Select(Gt(points, m_increment_limit), Splat(max_points),
+                                static_cast<Vec>(points + m_win_attack))
+                       : m_win_attack;
+        auto decayed =
+            Select(Gt(points, m_attack_decay), static_cast<Vec>(points - m_attack_decay), Splat(0));
+        return Select(Eq(friendly_count, Splat(danger_zone)), win,
+                      Select(Gt(Splat(danger_zone), enemy_count), decayed, points));
+    }
+
+    Vec Defense(Vec enemy_count, Vec points) const
+    {
+        // Below danger_zone, a line has at most one enemy stone
+        return Select(Eq(enemy_count, Splat(danger_zone)), m_danger_defense,
+                      Select(Gt(enemy_count, Splat(0)), m_defense, points));
+    }
+
+private:
+    /// Points stay below TicTacToeGame::npos, which marks the winning line
+    static constexpr uint8_t max_points = TicTacToeGame::npos - 1;
+
+    Vec m_win_attack;
+    bool m_win_attack_increment;
+    Vec m_increment_limit;
+    Vec m_attack_decay;
+    /// With one enemy stone on the line
+    Vec m_defense;
+    Vec m_danger_defense;
+};
+
+static_assert(board_size == 3, "the lane kernels count the stones of 3 cell lines");
+
+///
+/// \brief MinstdRand Same sequence as the std::minstd_rand of TicTacToeGame
+///
+class MinstdRand {
+public:
+    explicit MinstdRand(uint32_t seed)
+        : m_state{seed % modulus == 0 ? 1 : seed % modulus}
+    {
+    }
+
+    uint32_t operator()()
+    {
+        m_state = static_cast<uint32_t>(uint64_t{m_state} * 48271u % modulus);
+        return m_state;
+    }
+
+private:
+    static constexpr uint32_t modulus = 2147483647u;
+    uint32_t m_state;
+};
+
+} // namespace
+
+void GameBatch::Start(size_t count, PlayerSide human_side, PlayerType first_player,
+                      PolicyKind policy, uint32_t first_seed)
+{
+    if (policy == PolicyKind::learned) {
+        throw std::invalid_argument{"GameBatch only plays the point based policies"};
+    }
+    m_parameters = PolicyConfig::Current(policy);
+    m_human_side = human_side;
+    m_current_player = first_player;
+    m_moves = 0;
+    m_stride = (count + lane_block - 1) / lane_block * lane_block;
+
+    m_lanes.assign(planes * cell_count * m_stride, 0);
+    for (uint8_t c = 0; c < cell_count; ++c) {
+        auto points = m_parameters->InitialAttackPoints(c % board_size, c / board_size);
+        std::fill_n(Lanes(attack_points, c), m_stride, points);
+    }
+    m_ids.resize(count);
+    std::iota(m_ids.begin(), m_ids.end(), 0u);
+    m_results.assign(count, Result{GameStatus::in_progress, 0});
+    m_scratch.assign(4 * m_stride, 0);
+    m_running.resize(count);
+
+    if (first_player == PlayerType::computer) {
+        // Random first move, drawn as TicTacToeGame does; no point update follows it
+        for (size_t i = 0; i < count; ++i) {
+            MinstdRand rng{first_seed + static_cast<uint32_t>(i)};
+            auto x = rng() % board_size;
+            auto y = rng() % board_size;
+            auto cell = y * board_size + x;
+            Lanes(computer_stones, cell)[i] = 0xff;
+            Lanes(attack_points, cell)[i] = 0;
+        }
+        ++m_moves;
+        m_current_player = PlayerType::human;
+        Finish(false);
+    }
+}
+
+CellMask GameBatch::StoneMask(Plane plane, size_t lane) const
+{
+    CellMask stones = 0;
+    for (uint8_t c = 0; c < cell_count; ++c) {
+        if (Lanes(plane, c)[lane] != 0) {
+            stones |= static_cast<CellMask>(1u << c);
+        }
+    }
+    return stones;
+}
+
+CellMask GameBatch::EmptyCells(size_t lane) const
+{
+    return static_cast<CellMask>(
+        ~(StoneMask(human_stones, lane) | StoneMask(computer_stones, lane)) & all_cells);
+}
+
+PositionKey GameBatch::Position(size_t lane) const
+{
+    auto human = StoneMask(human_stones, lane);
+    auto computer = StoneMask(computer_stones, lane);
+    return m_human_side == PlayerSide::xs ? MakeKey(human, computer) : MakeKey(computer, human);
+}
+
+void GameBatch::HumanMoves(const uint8_t* cells)
+{
+    assert(m_current_player == PlayerType::human);
+    const size_t n = m_ids.size();
+    uint8_t* moves = m_scratch.data();
+    std::copy(cells, cells + n, moves);
+
+    for (uint8_t c = 0; c < cell_count; ++c) {
+        uint8_t* stones = Lanes(human_stones, c);
+        uint8_t* moved_lanes = Lanes(moved, c);
+        for (size_t i = 0; i < n; i += lane_block) {
+            auto move = Eq(Load(moves + i), Splat(c));
+            Store(moved_lanes + i, move);
+            Store(stones + i, Load(stones + i) | move);
+        }
+    }
+
+    UpdatePoints(true);
+    ++m_moves;
+    m_current_player = PlayerType::computer;
+    Finish(true);
+}
+
+void GameBatch::ComputerMoves()
+{
+    assert(m_current_player == PlayerType::computer);
+    const size_t n = m_ids.size();
+
+    // TicTacToeBoard::MaxScoreCell: the first empty cell with the highest score. Scores are
+    // offset by one so that 0 means no empty cell seen yet.
+    uint8_t* best_score = m_scratch.data();
+    uint8_t* best_cell = m_scratch.data() + m_stride;
+    std::fill_n(best_score, n, 0);
+    for (uint8_t c = 0; c < cell_count; ++c) {
+        const uint8_t* human = Lanes(human_stones, c);
+        const uint8_t* computer = Lanes(computer_stones, c);
+        const uint8_t* attack = Lanes(attack_points, c);
+        const uint8_t* defense = Lanes(defense_points, c);
+        for (size_t i = 0; i < n; i += lane_block) {
+            auto empty = ~(Load(human + i) | Load(computer + i));
+            auto score = static_cast<Vec>(Load(attack + i) + Load(defense + i) + Splat(1));
+            auto best = Load(best_score + i);
+            auto better = empty & Gt(score, best);
+            Store(best_score + i, Select(better, score, best));
+            Store(best_cell + i, Select(better, Splat(c), Load(best_cell + i)));
+        }
+    }
+    for (uint8_t c = 0; c < cell_count; ++c) {
+        uint8_t* stones = Lanes(computer_stones, c);
+        uint8_t* moved_lanes = Lanes(moved, c);
+        for (size_t i = 0; i < n; i += lane_block) {
+            auto move = Eq(Load(best_cell + i), Splat(c));
+            Store(moved_lanes + i, move);
+            Store(stones + i, Load(stones + i) | move);
+        }
+    }
+
+    UpdatePoints(false);
+    ++m_moves;
+    m_current_player = PlayerType::human;
+    Finish(false);
+}
+
+void GameBatch::UpdatePoints(bool defense)
+{
+    const size_t n = m_ids.size();
+    const PointLanes policy{*m_parameters};
+
+    // The moved cell is taken: TicTacToeGame::UpdateCell clears its points
+    for (uint8_t c = 0; c < cell_count; ++c) {
+        const uint8_t* moved_lanes = Lanes(moved, c);
+        uint8_t* attack = Lanes(attack_points, c);
+        uint8_t* defense_lanes = Lanes(defense_points, c);
+        for (size_t i = 0; i < n; i += lane_block) {
+            auto keep = ~Load(moved_lanes + i);
+            Store(attack + i, Load(attack + i) & keep);
+            Store(defense_lanes + i, Load(defense_lanes + i) & keep);
+        }
+    }
+
+    // Every line through the move updates its empty cells. Two such lines only share the
+    // moved cell, so the order of the lines does not matter.
+    for (const auto& line : lines) {
+        const uint8_t* human[board_size];
+        const uint8_t* computer[board_size];
+        const uint8_t* moved_lanes[board_size];
+        uint8_t* attack[board_size];
+        uint8_t* defense_lanes[board_size];
+        for (uint8_t k = 0; k < board_size; ++k) {
+            human[k] = Lanes(human_stones, line.cells[k]);
+            computer[k] = Lanes(computer_stones, line.cells[k]);
+            moved_lanes[k] = Lanes(moved, line.cells[k]);
+            attack[k] = Lanes(attack_points, line.cells[k]);
+            defense_lanes[k] = Lanes(defense_points, line.cells[k]);
+        }
+
+        for (size_t i = 0; i < n; i += lane_block) {
+            Vec touched = Splat(0);
+            Vec h[board_size], m[board_size];
+            for (uint8_t k = 0; k < board_size; ++k) {
+                if (line.touched_by & (1u << line.cells[k])) {
+                    touched |= Load(moved_lanes[k] + i);
+                }
+                h[k] = Load(human[k] + i);
+                m[k] = Load(computer[k] + i);
+            }
+            auto enemy_count = Count(h[0], h[1], h[2]);
+            auto friendly_count = Count(m[0], m[1], m[2]);
+            for (uint8_t k = 0; k < board_size; ++k) {
+                auto update = touched & ~(h[k] | m[k]);
+                auto points = Load(attack[k] + i);
+                Store(attack[k] + i,
+                      Select(update, policy.Attack(enemy_count, friendly_count, points), points));
+                if (defense) {
+                    points = Load(defense_lanes[k] + i);
+                    Store(defense_lanes[k] + i,
+                          Select(update, policy.Defense(enemy_count, points), points));
+                }
+            }
+        }
+    }
+}
+
+void GameBatch::Finish(bool human_moved)
+{
+    // No side has a line before its third stone, and the board is not full yet
+    if (m_moves < 2 * board_size - 1) {
+        return;
+    }
+
+    const size_t n = m_ids.size();
+    const auto mover = human_moved ? human_stones : computer_stones;
+    auto mover_side = human_moved ? m_human_side
+                                  : (m_human_side == PlayerSide::os ? PlayerSide::xs
+                                                                    : PlayerSide::os);
+    auto winner = mover_side == PlayerSide::xs ? GameStatus::xs_winner : GameStatus::os_winner;
+
+    uint8_t* won = m_scratch.data() + 2 * m_stride;
+    std::fill_n(won, m_stride, 0);
+    for (const auto& line : lines) {
+        const uint8_t* a = Lanes(mover, line.cells[0]);
+        const uint8_t* b = Lanes(mover, line.cells[1]);
+        const uint8_t* c = Lanes(mover, line.cells[2]);
+        for (size_t i = 0; i < n; i += lane_block) {
+            Store(won + i, Load(won + i) | (Load(a + i) & Load(b + i) & Load(c + i)));
+        }
+    }
+
+    // As in TicTacToeGame::UpdateGame, a full board is a draw unless the last move won
+    bool full = m_moves == cell_count;
+    size_t running = 0;
+    size_t first_finished = n;
+    for (size_t i = 0; i < n; i += lane_block) {
+        // Whole blocks without a finished game are the common case. The lanes past n hold
+        // stale stones, so the last partial block is checked lane by lane.
+        if (!full && i + lane_block <= n && !Any(Load(won + i))) {
+            for (size_t k = i; k < i + lane_block; ++k) {
+                m_running[running++] = static_cast<uint32_t>(k);
+            }
+            continue;
+        }
+        for (size_t k = i; k < std::min(i + lane_block, n); ++k) {
+            if (full || won[k] != 0) {
+                auto& result = m_results[m_ids[k]];
+                result.status = won[k] != 0 ? winner : GameStatus::draw;
+                result.position = Position(k);
+                first_finished = std::min(first_finished, k);
+            }
+            else {
+                m_running[running++] = static_cast<uint32_t>(k);
+            }
+        }
+    }
+    if (running == n) {
+        return;
+    }
+
+    // Stable compaction of the running lanes; those before the first finished one stay put
+    auto compact = [this, first_finished, running](auto* lanes) {
+        for (size_t j = first_finished; j < running; ++j) {
+            lanes[j] = lanes[m_running[j]];
+        }
+    };
+    for (auto plane : {human_stones, computer_stones, attack_points, defense_points}) {
+        for (uint8_t c = 0; c < cell_count; ++c) {
+            compact(Lanes(plane, c));
+        }
+    }
+    compact(m_ids.data());
+    m_ids.resize(running);
+}
+
+} // namespace tictactoe
@@ -0,0 +1,152 @@
+/// @file
+///
+/// @author
+///
+/// @copyright
+
+#ifndef TICTACTOE_BATCH_HPP
+#define TICTACTOE_BATCH_HPP
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "tictactoecore_global.hpp"
+#include <tictactoe_game.hpp>
+#include <tictactoe_position.hpp>
+
+namespace tictactoe {
+
+///
+/// \brief The GameBatch class, many games against the same policy played in lockstep
+///
+/// The games are stored as a structure of arrays: for every cell, one byte per game (lane) for
+/// each side's stone, the attack points and the defense points. Every call plays one ply in
+/// all the running games with branch-free kernels working on 16 lanes per instruction (GCC
+/// and Clang vector extensions, one lane at a time with other compilers), then compacts the
+/// finished games out of the lanes.
+///
+/// The games follow TicTacToeGame exactly (same rules, same attack and defense updates, same
+/// tie breaks and same first computer move for the same seed), for the point based policies:
+/// Start() pins the parameters published for the policy, as a game does. All the games share
+/// the human side and first player, so the human and computer plies alternate for the whole
+/// batch.
+///
+class TICTACTOECORESHARED_EXPORT GameBatch final {
+public:
+    ///
+    /// \brief The Result struct, final state of a game
+    ///
+    struct Result {
+        GameStatus status{GameStatus::not_started};
+        /// Final position (see tictactoe_position.hpp)
+        PositionKey position{0};
+    };
+
+    ///
+    /// \brief Start Start count games
+    /// \param count
+    /// \param human_side X or O for the human?
+    /// \param first_player Who goes first
+    /// \param policy Any PolicyKind but learned
+    /// \param first_seed Game i is seeded with first_seed + i, as TicTacToeGame::Seed()
+    ///
+    void Start(size_t count, PlayerSide human_side, PlayerType first_player, PolicyKind policy,
+               uint32_t first_seed);
+
+    /// Number of games still running
+    size_t Active() const { return m_ids.size(); }
+
+    /// Who plays the next ply of all the running games
+    PlayerType ToMove() const { return m_current_player; }
+
+    /// Game index (0 to count - 1) of a running lane
+    uint32_t Game(size_t lane) const { return m_ids[lane]; }
+
+    ///
+    /// \brief EmptyCells Legal moves of a running lane
+    /// \param lane
+    /// \return
+    ///
+    CellMask EmptyCells(size_t lane) const;
+
+    ///
+    /// \brief Position Current position of a running lane
+    /// \param lane
+    /// \return
+    ///
+    PositionKey Position(size_t lane) const;
+
+    ///
+    /// \brief HumanMoves Play the human ply of all the running games
+    /// \param cells One empty cell index (y * board_size + x) per running lane
+    ///
+    void HumanMoves(const uint8_t* cells);
+
+    ///
+    /// \brief ComputerMoves Play the computer ply of all the running games
+    ///
+    void ComputerMoves();
+
+    ///
+    /// \brief Results Final state of each game, by game index
+    /// \return
+    ///
+    const std::vector<Result>& Results() const { return m_results; }
+
+private:
+    static constexpr size_t cell_count = board_size * board_size;
+
+    ///
+    /// \brief The Plane enum, per cell lane arrays
+    ///
+    /// Stones and moves are byte masks (0xff or 0), the points plain bytes.
+    ///
+    enum Plane { human_stones, computer_stones, moved, attack_points, defense_points, planes };
+
+    uint8_t* Lanes(Plane plane, size_t cell)
+    {
+        return m_lanes.data() + (plane * cell_count + cell) * m_stride;
+    }
+
+    const uint8_t* Lanes(Plane plane, size_t cell) const
+    {
+        return m_lanes.data() + (plane * cell_count + cell) * m_stride;
+    }
+
+    ///
+    /// \brief StoneMask Stones of a side on a running lane
+    ///
+    CellMask StoneMask(Plane plane, size_t lane) const;
+
+    ///
+    /// \brief UpdatePoints Attack (and defense) updates after the moves in the moved plane
+    /// \param defense Also update the defense points (after a human move)
+    ///
+    void UpdatePoints(bool defense);
+
+    ///
+    /// \brief Finish Record the results of the finished games and compact the lanes
+    /// \param human_moved Which side played the last ply
+    ///
+    void Finish(bool human_moved);
+
+private:
+    std::shared_ptr<const PolicyParameters> m_parameters;
+    PlayerSide m_human_side{PlayerSide::os};
+    PlayerType m_current_player{PlayerType::human};
+    size_t m_moves{0};
+    /// Distance between two planes, the game count rounded up to the kernel width
+    size_t m_stride{0};
+    std::vector<uint8_t> m_lanes;
+    /// Game index of each running lane
+    std::vector<uint32_t> m_ids;
+    std::vector<Result> m_results;
+    /// Scratch lanes, sized once by Start()
+    std::vector<uint8_t> m_scratch;
+    /// Lanes still running after the last ply, in order
+    std::vector<uint32_t> m_running;
+};
+
+} // namespace tictactoe
+
+#endif // TICTACTOE_BATCH_HPP
@@ -1,22 +1,52 @@
 #include "tictactoe_board.hpp"
+#include "tictactoe_parameters.hpp"
+#include "tictactoe_trace.hpp"
 #include <algorithm>
 #include <cassert>
+#include <cstring>
+#include <type_traits>
 
 namespace tictactoe {
 
-TicTacToeBoard::TicTacToeBoard()
+namespace {
+
+using Cells = std::array<Cell, board_size * board_size>;
+
+static_assert(std::is_trivially_copyable<Cell>::value, "the board is restored with memcpy");
+
+///
+/// \brief InitialBoard The empty board, scored with the initial attack points of the normal
+/// policy
+///
+/// The point based policies write their own initial points on each new game.
+///
+constexpr Cells InitialBoard()
 {
-    InitCell(0, 0, 3);
-    InitCell(0, 1, 2);
-    InitCell(0, 2, 3);
+    constexpr auto parameters = PolicyParameters::Normal();
+    Cells cells{};
+    for (uint8_t y = 0; y < board_size; ++y) {
+        for (uint8_t x = 0; x < board_size; ++x) {
+            auto& cell = cells[y * board_size + x];
+            cell.x = x;
+            cell.y = y;
+            cell.attack_points = parameters.InitialAttackPoints(x, y);
+        }
+    }
+    return cells;
+}
+
+constexpr Cells initial_board = InitialBoard();
 
-    InitCell(1, 0, 2);
-    InitCell(1, 1, 4);
-    InitCell(1, 2, 2);
+} // namespace
 
-    InitCell(2, 0, 3);
-    InitCell(2, 1, 2);
-    InitCell(2, 2, 3);
+TicTacToeBoard::TicTacToeBoard()
+{
+    Reset();
+}
+
+void TicTacToeBoard::Reset()
+{
+    std::memcpy(m_board.data(), initial_board.data(), sizeof(m_board));
 }
 
 Cell& TicTacToeBoard::At(uint8_t x, uint8_t y)
@@ -33,6 +63,7 @@ const Cell& TicTacToeBoard::At(uint8_t x, uint8_t y) const
 
 Cell& TicTacToeBoard::MaxScoreCell()
 {
+    TICTACTOE_TRACE_SCOPE("TicTacToeBoard::MaxScoreCell");
     auto first_empty = std::find_if(m_board.begin(), m_board.end(),
                                     [](const auto& c) { return c.value == CellValue::None; });
     assert(first_empty != m_board.end());
@@ -42,44 +73,21 @@ Cell& TicTacToeBoard::MaxScoreCell()
     });
 }
 
-void TicTacToeBoard::ForEachX(uint8_t x, const ForEachCallable& pred, bool include_empty)
-{
-    for (uint8_t i = 0; i < board_size; ++i) {
-        auto& cell = At(x, i);
-        if (include_empty || cell.value == CellValue::None) {
-            pred(cell);
-        }
-    }
-}
-
-void TicTacToeBoard::ForEachY(uint8_t y, const ForEachCallable& pred, bool include_empty)
-{
-    for (uint8_t i = 0; i < board_size; ++i) {
-        auto& cell = At(i, y);
-        if (include_empty || cell.value == CellValue::None) {
-            pred(cell);
-        }
-    }
-}
-
-void TicTacToeBoard::ForEachD1(const ForEachCallable& pred, bool include_empty)
-{
-    for (uint8_t i = 0; i < board_size; ++i) {
-        auto& cell = At(i, i);
-        if (include_empty || cell.value == CellValue::None) {
-            pred(cell);
-        }
-    }
-}
-
-void TicTacToeBoard::ForEachD2(const ForEachCallable& pred, bool include_empty)
+Cell& TicTacToeBoard::MaxScoreCell(uint16_t cells)
 {
-    for (uint8_t i = 0; i < board_size; ++i) {
-        auto& cell = At(i, board_size - i - 1);
-        if (include_empty || cell.value == CellValue::None) {
-            pred(cell);
+    TICTACTOE_TRACE_SCOPE("TicTacToeBoard::MaxScoreCell");
+    assert(cells != 0);
+    Cell* best = nullptr;
+    for (size_t i = 0; i < m_board.size(); ++i) {
+        auto& cell = m_board[i];
+        if ((cells & (1u << i)) &&
+            (!best || cell.attack_points + cell.defense_points >
+                          best->attack_points + best->defense_points)) {
+            assert(cell.value == CellValue::None);
+            best = &cell;
         }
     }
+    return *best;
 }
 
 uint16_t TicTacToeBoard::CountX(uint8_t x, CellValue val) const
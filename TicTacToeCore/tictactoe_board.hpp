@@ -3,7 +3,6 @@
 
 #include <array>
 #include <cstdint>
-#include <functional>
 
 namespace tictactoe {
 
@@ -37,8 +36,6 @@ struct Cell {
 /// \brief The TicTacToeBoard class
 ///
 class TicTacToeBoard final {
-    using ForEachCallable = std::function<void(Cell&)>;
-
 public:
     ///
     /// \brief TicTacToeBoard constructor
@@ -70,6 +67,11 @@ public:
     ///
     TicTacToeBoard& operator=(TicTacToeBoard&&) = default;
 
+    ///
+    /// \brief Reset Restore the initial board, a plain copy of a precomputed image
+    ///
+    void Reset();
+
     ///
     /// \brief At Non-const getter for board position
     /// \param x
@@ -92,13 +94,32 @@ public:
     ///
     Cell& MaxScoreCell();
 
+    ///
+    /// \brief MaxScoreCell Get the position with the highest score among some empty cells
+    /// \param cells Non-empty set of empty cells, bit y * board_size + x per cell
+    /// \return The first one on ties
+    ///
+    Cell& MaxScoreCell(uint16_t cells);
+
     ///
     /// \brief ForEachX Convenience cell iterator for a given column
+    ///
+    /// The iterators are templates so the per-cell lambdas are inlined instead of being
+    /// wrapped (and possibly heap allocated) in a std::function.
     /// \param x
     /// \param pred
     /// \param include_empty
     ///
-    void ForEachX(uint8_t x, const ForEachCallable& pred, bool include_empty = false);
+    template <typename Pred>
+    void ForEachX(uint8_t x, Pred&& pred, bool include_empty = false)
+    {
+        for (uint8_t i = 0; i < board_size; ++i) {
+            auto& cell = At(x, i);
+            if (include_empty || cell.value == CellValue::None) {
+                pred(cell);
+            }
+        }
+    }
 
     ///
     /// \brief ForEachY Convenience cell iterator for a given row
@@ -106,21 +127,48 @@ public:
     /// \param pred
     /// \param include_empty
     ///
-    void ForEachY(uint8_t y, const ForEachCallable& pred, bool include_empty = false);
+    template <typename Pred>
+    void ForEachY(uint8_t y, Pred&& pred, bool include_empty = false)
+    {
+        for (uint8_t i = 0; i < board_size; ++i) {
+            auto& cell = At(i, y);
+            if (include_empty || cell.value == CellValue::None) {
+                pred(cell);
+            }
+        }
+    }
 
     ///
     /// \brief ForEachD1 Convenience cell iterator for the first diagonal
     /// \param pred
     /// \param include_empty
     ///
-    void ForEachD1(const ForEachCallable& pred, bool include_empty = false);
+    template <typename Pred>
+    void ForEachD1(Pred&& pred, bool include_empty = false)
+    {
+        for (uint8_t i = 0; i < board_size; ++i) {
+            auto& cell = At(i, i);
+            if (include_empty || cell.value == CellValue::None) {
+                pred(cell);
+            }
+        }
+    }
 
     ///
     /// \brief ForEachD2 Convenience cell iterator for the second diagonal
     /// \param pred
     /// \param include_empty
     ///
-    void ForEachD2(const ForEachCallable& pred, bool include_empty = false);
+    template <typename Pred>
+    void ForEachD2(Pred&& pred, bool include_empty = false)
+    {
+        for (uint8_t i = 0; i < board_size; ++i) {
+            auto& cell = At(i, board_size - i - 1);
+            if (include_empty || cell.value == CellValue::None) {
+                pred(cell);
+            }
+        }
+    }
 
     ///
     /// \brief CountX Count positions (X or O) for a given row
@@ -152,20 +200,6 @@ public:
     ///
     uint16_t CountD2(CellValue val) const;
 
-private:
-    ///
-    /// \brief InitCell
-    /// \param x
-    /// \param y
-    /// \param attack_points
-    ///
-    void InitCell(uint8_t x, uint8_t y, uint8_t attack_points)
-    {
-        At(x, y).attack_points = attack_points;
-        At(x, y).x = x;
-        At(x, y).y = y;
-    }
-
 private:
     ///
     /// \brief m_board Storage for the board data
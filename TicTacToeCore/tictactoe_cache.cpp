@@ -0,0 +1,335 @@
+/// @file
+///
+/// @author
+///
+/// @copyright
+
+#include "tictactoe_cache.hpp"
+#include "tictactoe_position.hpp"
+#include <array>
+#include <cassert>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <thread>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define TICTACTOE_CACHE_HAS_SHM
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace tictactoe {
+
+///
+/// \brief The Header struct, start of the segment
+///
+struct EvaluationCache::Header {
+    /// Initialization progress: 0 while the creator sets the header up, then ready
+    std::atomic<uint32_t> state;
+    std::array<char, 4> magic;
+    uint32_t version;
+    uint32_t cells;
+    uint64_t capacity;
+};
+
+///
+/// \brief The Entry struct, one cached search
+///
+struct EvaluationCache::Entry {
+    /// 0 for an empty entry, else a packed tag, result and version (see Tag())
+    std::atomic<uint64_t> word;
+};
+
+namespace {
+
+constexpr std::array<char, 4> magic{{'T', 'T', 'T', 'C'}};
+/// Bumped on any change of the segment layout or of the search results
+constexpr uint32_t layout_version = 2;
+constexpr uint32_t header_ready = 1;
+
+// Entry word, from the low bits: the canonical position (X then O stones), the wins, the safe
+// moves (on the canonical position), the depth, the used bit and the version
+constexpr unsigned cells = board_size * board_size;
+constexpr uint64_t cell_bits = (uint64_t{1} << cells) - 1;
+constexpr unsigned wins_shift = 2 * cells;
+constexpr unsigned safe_shift = 3 * cells;
+constexpr unsigned depth_shift = 4 * cells;
+constexpr uint64_t used_bit = uint64_t{1} << (depth_shift + 8);
+constexpr unsigned version_shift = depth_shift + 9;
+/// The tag bits: position, depth and used bit
+constexpr uint64_t tag_bits = cell_bits | cell_bits << cells | uint64_t{0xff} << depth_shift |
+                              used_bit;
+
+static_assert(version_shift + 16 <= 64, "no room left for the entry version");
+
+// The segment is shared between processes: the atomics must not fall back to locks
+static_assert(std::atomic<uint32_t>::is_always_lock_free &&
+                  std::atomic<uint64_t>::is_always_lock_free,
+              "the cache needs lock-free 32 and 64 bit atomics");
+
+uint64_t Tag(PositionKey canonical, uint8_t depth)
+{
+    return used_bit | (uint64_t{depth} << depth_shift) |
+           (uint64_t{OStones(canonical)} << cells) | XStones(canonical);
+}
+
+size_t Hash(uint64_t tag)
+{
+    return static_cast<size_t>((tag * 0x9e3779b97f4a7c15ull) >> 32);
+}
+
+template <typename Header, typename Entry>
+size_t SegmentSize(size_t capacity)
+{
+    // Entries start on their own cache line
+    constexpr size_t line = 64;
+    return (sizeof(Header) + line - 1) / line * line + capacity * sizeof(Entry);
+}
+
+} // namespace
+
+std::atomic<EvaluationCache*> EvaluationCache::s_installed{nullptr};
+
+EvaluationCache::~EvaluationCache()
+{
+    Close();
+}
+
+bool EvaluationCache::Open(const std::string& name, size_t capacity, std::string* error)
+{
+    Close();
+    std::string reason;
+#ifdef TICTACTOE_CACHE_HAS_SHM
+    size_t entries = probe_count;
+    while (entries < capacity) {
+        entries *= 2;
+    }
+
+    // An abandoned segment is removed by the first attempt, the second one creates it again
+    auto attach = Map(name, entries, reason);
+    if (attach == Attach::stale) {
+        attach = Map(name, entries, reason);
+    }
+    if (attach == Attach::mapped) {
+        return true;
+    }
+#else
+    static_cast<void>(name);
+    static_cast<void>(capacity);
+    reason = "shared memory is not supported on this platform";
+#endif
+    Close();
+    if (error) {
+        *error = reason;
+    }
+    return false;
+}
+
+EvaluationCache::Attach EvaluationCache::Map(const std::string& name, size_t entries,
+                                             std::string& reason)
+{
+#ifdef TICTACTOE_CACHE_HAS_SHM
+    // The process that creates the segment sizes it and sets the header up
+    bool creator = true;
+    int fd = shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+    if (fd < 0 && errno == EEXIST) {
+        creator = false;
+        fd = shm_open(name.c_str(), O_RDWR, 0600);
+    }
+    if (fd < 0) {
+        reason = "cannot open " + name + ": " + std::strerror(errno);
+        return Attach::failed;
+    }
+
+    auto fail = [this, &name, &reason, creator](const std::string& why) {
+        Close();
+        // Nobody else can use a segment its creator did not set up
+        if (creator) {
+            shm_unlink(name.c_str());
+        }
+        reason = why;
+        return Attach::failed;
+    };
+
+    // Removes the segment if the name still refers to it: another process may already have
+    // replaced it
+    auto abandon = [this, &name, &reason](int stale_fd, const std::string& why) {
+        struct stat stale {}, current {};
+        int current_fd = shm_open(name.c_str(), O_RDWR, 0600);
+        bool same = current_fd >= 0 && fstat(stale_fd, &stale) == 0 &&
+                    fstat(current_fd, &current) == 0 && stale.st_dev == current.st_dev &&
+                    stale.st_ino == current.st_ino;
+        if (current_fd >= 0) {
+            close(current_fd);
+        }
+        if (same) {
+            shm_unlink(name.c_str());
+        }
+        Close();
+        reason = why;
+        return Attach::stale;
+    };
+
+    struct stat status {};
+    bool sized = false;
+    if (creator) {
+        m_size = SegmentSize<Header, Entry>(entries);
+        sized = ftruncate(fd, static_cast<off_t>(m_size)) == 0;
+    }
+    else {
+        // Wait for the creator to size it
+        for (int i = 0; i < 1000 && !sized; ++i) {
+            sized = fstat(fd, &status) == 0 && status.st_size > 0;
+            if (!sized) {
+                std::this_thread::sleep_for(std::chrono::milliseconds{1});
+            }
+        }
+        m_size = static_cast<size_t>(status.st_size);
+        if (!sized) {
+            auto attach = abandon(fd, name + " was never sized");
+            close(fd);
+            return attach;
+        }
+    }
+    void* memory = sized && m_size >= sizeof(Header)
+                       ? mmap(nullptr, m_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0)
+                       : MAP_FAILED;
+    if (memory == MAP_FAILED) {
+        close(fd);
+        m_size = 0;
+        return fail("cannot map " + name);
+    }
+    m_header = static_cast<Header*>(memory);
+
+    if (creator) {
+        // The new segment is zero filled: the entries are empty
+        m_header->magic = magic;
+        m_header->version = layout_version;
+        m_header->cells = board_size * board_size;
+        m_header->capacity = entries;
+        m_header->state.store(header_ready, std::memory_order_release);
+    }
+    else {
+        for (int i = 0; i < 1000 && m_header->state.load(std::memory_order_acquire) !=
+                                        header_ready;
+             ++i) {
+            std::this_thread::sleep_for(std::chrono::milliseconds{1});
+        }
+        if (m_header->state.load(std::memory_order_acquire) != header_ready) {
+            auto attach = abandon(fd, name + " was not initialized");
+            close(fd);
+            return attach;
+        }
+        if (m_header->magic != magic || m_header->version != layout_version ||
+            m_header->cells != board_size * board_size ||
+            (m_header->capacity & (m_header->capacity - 1)) != 0 ||
+            m_size != SegmentSize<Header, Entry>(m_header->capacity)) {
+            close(fd);
+            Close();
+            reason = name + " is not a compatible cache";
+            return Attach::failed;
+        }
+    }
+    close(fd);
+
+    m_mask = m_header->capacity - 1;
+    m_entries = reinterpret_cast<Entry*>(static_cast<char*>(memory) + m_size -
+                                         (m_mask + 1) * sizeof(Entry));
+    return Attach::mapped;
+#else
+    static_cast<void>(name);
+    static_cast<void>(entries);
+    reason = "shared memory is not supported on this platform";
+    return Attach::failed;
+#endif
+}
+
+void EvaluationCache::Close()
+{
+#ifdef TICTACTOE_CACHE_HAS_SHM
+    if (m_header) {
+        munmap(m_header, m_size);
+    }
+#endif
+    m_header = nullptr;
+    m_entries = nullptr;
+    m_mask = 0;
+    m_size = 0;
+}
+
+bool EvaluationCache::Remove(const std::string& name)
+{
+#ifdef TICTACTOE_CACHE_HAS_SHM
+    return shm_unlink(name.c_str()) == 0;
+#else
+    static_cast<void>(name);
+    return false;
+#endif
+}
+
+bool EvaluationCache::Find(CellMask own, CellMask opponent, uint8_t depth,
+                           SearchResult& result) const
+{
+    assert(IsOpen());
+    uint8_t symmetry = 0;
+    auto tag = Tag(CanonicalKey(MakeKey(own, opponent), &symmetry), depth);
+    auto index = Hash(tag);
+
+    for (size_t i = 0; i < probe_count; ++i) {
+        auto word = m_entries[(index + i) & m_mask].word.load(std::memory_order_acquire);
+        if ((word & used_bit) == 0) {
+            return false;
+        }
+        if ((word & tag_bits) == tag) {
+            auto inverse = InverseSymmetry(symmetry);
+            result.wins =
+                TransformMask(static_cast<CellMask>((word >> wins_shift) & cell_bits), inverse);
+            result.safe =
+                TransformMask(static_cast<CellMask>((word >> safe_shift) & cell_bits), inverse);
+            result.nodes = 0;
+            result.complete = true;
+            return true;
+        }
+    }
+    return false;
+}
+
+void EvaluationCache::Store(CellMask own, CellMask opponent, uint8_t depth,
+                            const SearchResult& result)
+{
+    assert(IsOpen() && result.complete);
+    uint8_t symmetry = 0;
+    auto tag = Tag(CanonicalKey(MakeKey(own, opponent), &symmetry), depth);
+    auto index = Hash(tag);
+
+    // The entry of the position or the first empty one, else replace the first probed
+    auto* target = &m_entries[index & m_mask];
+    auto word = target->word.load(std::memory_order_relaxed);
+    for (size_t i = 0; i < probe_count; ++i) {
+        auto& entry = m_entries[(index + i) & m_mask];
+        auto probed = entry.word.load(std::memory_order_relaxed);
+        if ((probed & tag_bits) == tag || (probed & used_bit) == 0) {
+            target = &entry;
+            word = probed;
+            break;
+        }
+    }
+
+    auto version = (word >> version_shift) + 1;
+    auto value = tag | uint64_t{TransformMask(result.wins, symmetry)} << wins_shift |
+                 uint64_t{TransformMask(result.safe, symmetry)} << safe_shift |
+                 version << version_shift;
+    // Fails if another writer replaced the entry since it was read: that one wins
+    target->word.compare_exchange_strong(word, value, std::memory_order_release,
+                                         std::memory_order_relaxed);
+}
+
+void EvaluationCache::Install(EvaluationCache* cache)
+{
+    s_installed.store(cache, std::memory_order_release);
+}
+
+} // namespace tictactoe
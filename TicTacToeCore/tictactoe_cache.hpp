@@ -0,0 +1,133 @@
+/// @file
+///
+/// @author
+///
+/// @copyright
+
+#ifndef TICTACTOE_CACHE_HPP
+#define TICTACTOE_CACHE_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include "tictactoecore_global.hpp"
+#include <tictactoe_search.hpp>
+
+namespace tictactoe {
+
+///
+/// \brief The EvaluationCache class, search results shared by the processes of a host
+///
+/// The table lives in a POSIX shared memory segment (shm_open/mmap), so every process opening
+/// the same name shares it and it outlives them: a restarted server starts with a warm cache.
+/// Positions are stored once per symmetry class, keyed by canonical position and search depth.
+/// The table uses lock-free open addressing with a short linear probe. Each entry is a single
+/// 64-bit word holding the key, the result and a version counter: a writer replaces it with a
+/// compare-and-swap from the word it read, bumping the version, so a reader always sees a whole
+/// entry and no entry is left locked by a process killed during an update. Writers never wait;
+/// of two writers racing for an entry, one gives up.
+///
+/// Install() a cache to make Search() consult it. Only complete searches (not cut by the node
+/// budget) are stored: their results are exact and do not depend on the budget, so it is not
+/// part of the key.
+///
+class TICTACTOECORESHARED_EXPORT EvaluationCache final {
+public:
+    /// Entries probed per lookup
+    static constexpr size_t probe_count = 8;
+
+    EvaluationCache() = default;
+
+    /// Unmaps the segment, which stays in place for the other processes
+    ~EvaluationCache();
+
+    EvaluationCache(EvaluationCache const&) = delete;
+    EvaluationCache& operator=(EvaluationCache const&) = delete;
+
+    ///
+    /// \brief Open Map the named segment, creating it if needed
+    ///
+    /// An existing segment keeps its capacity; one written by an incompatible version is
+    /// rejected (Remove() it). A segment whose creator failed or died before setting it up
+    /// (still unsized or uninitialized after a second) is removed and created again.
+    /// \param name Segment name, e.g. "/tictactoe-cache"
+    /// \param capacity Number of entries of a new segment, rounded up to a power of two
+    /// \param error Set to the reason of a failure, if not null
+    /// \return False (and the cache closed) on failure
+    ///
+    bool Open(const std::string& name, size_t capacity, std::string* error = nullptr);
+
+    ///
+    /// \brief Close Unmap the segment
+    ///
+    void Close();
+
+    ///
+    /// \brief Remove Delete a named segment; the processes mapping it keep their mapping
+    /// \param name
+    /// \return
+    ///
+    static bool Remove(const std::string& name);
+
+    /// True once opened
+    bool IsOpen() const { return m_header != nullptr; }
+
+    ///
+    /// \brief Find Look up the search result of a position
+    /// \param own Stones of the side to move
+    /// \param opponent
+    /// \param depth
+    /// \param result Receives the wins and safe moves on a hit
+    /// \return True on a hit
+    ///
+    bool Find(CellMask own, CellMask opponent, uint8_t depth, SearchResult& result) const;
+
+    ///
+    /// \brief Store Record the search result of a position
+    /// \param own Stones of the side to move
+    /// \param opponent
+    /// \param depth
+    /// \param result A complete search result
+    ///
+    void Store(CellMask own, CellMask opponent, uint8_t depth, const SearchResult& result);
+
+    ///
+    /// \brief Install Make Search() use a cache
+    /// \param cache nullptr to stop using one; it must stay open while installed
+    ///
+    static void Install(EvaluationCache* cache);
+
+    /// The cache used by Search(), if any
+    static EvaluationCache* Installed() { return s_installed.load(std::memory_order_acquire); }
+
+private:
+    struct Header;
+    struct Entry;
+
+    ///
+    /// \brief The Attach enum, outcome of one attempt to map the segment
+    ///
+    enum class Attach { mapped, failed, stale };
+
+    ///
+    /// \brief Map Open or create the segment and map it
+    /// \param name
+    /// \param entries Capacity of a new segment, a power of two
+    /// \param reason Set to the reason of a failure
+    /// \return stale if an abandoned segment was removed, so that a new one can be created
+    ///
+    Attach Map(const std::string& name, size_t entries, std::string& reason);
+
+    Header* m_header{nullptr};
+    Entry* m_entries{nullptr};
+    /// Capacity - 1
+    size_t m_mask{0};
+    /// Mapped bytes
+    size_t m_size{0};
+
+    static std::atomic<EvaluationCache*> s_installed;
+};
+
+} // namespace tictactoe
+
+#endif // TICTACTOE_CACHE_HPP
@@ -0,0 +1,299 @@
+/// @file
+///
+/// @author
+///
+/// @copyright
+
+#include "tictactoe_evaluator.hpp"
+#include "tictactoe_game.hpp"
+#include "tictactoe_trace.hpp"
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <fstream>
+#include <vector>
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define TICTACTOE_HAS_AVX2_KERNEL
+#include <immintrin.h>
+#endif
+
+namespace tictactoe {
+
+namespace {
+
+///
+/// \brief DotScalar Clipped activation dotted with the output weights, portable version
+///
+int32_t DotScalar(const int16_t* accumulator, const int16_t* weights)
+{
+    int32_t sum = 0;
+    for (size_t i = 0; i < Evaluator::hidden; ++i) {
+        int32_t activation = std::min<int16_t>(std::max<int16_t>(accumulator[i], 0),
+                                               Evaluator::activation_max);
+        sum += activation * weights[i];
+    }
+    return sum;
+}
+
+#ifdef TICTACTOE_HAS_AVX2_KERNEL
+///
+/// \brief DotAvx2 Same as DotScalar, 16 units per step
+///
+__attribute__((target("avx2"))) int32_t DotAvx2(const int16_t* accumulator,
+                                                const int16_t* weights)
+{
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i max = _mm256_set1_epi16(Evaluator::activation_max);
+    __m256i sum = _mm256_setzero_si256();
+    for (size_t i = 0; i < Evaluator::hidden; i += 16) {
+        // The accumulators live in the games, which are not over-aligned
+        auto a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(accumulator + i));
+        auto w = _mm256_load_si256(reinterpret_cast<const __m256i*>(weights + i));
+        a = _mm256_min_epi16(_mm256_max_epi16(a, zero), max);
+        sum = _mm256_add_epi32(sum, _mm256_madd_epi16(a, w));
+    }
+    auto half = _mm_add_epi32(_mm256_castsi256_si128(sum), _mm256_extracti128_si256(sum, 1));
+    half = _mm_hadd_epi32(half, half);
+    half = _mm_hadd_epi32(half, half);
+    return _mm_cvtsi128_si32(half);
+}
+
+bool HasAvx2()
+{
+    // Initialized on first use: __builtin_cpu_supports() needs the CPU model, which may not be
+    // set up yet while the static initializers of the library run
+    static const bool has_avx2 = [] {
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("avx2") != 0;
+    }();
+    return has_avx2;
+}
+#endif
+
+int32_t Dot(const int16_t* accumulator, const int16_t* weights)
+{
+#ifdef TICTACTOE_HAS_AVX2_KERNEL
+    if (HasAvx2()) {
+        return DotAvx2(accumulator, weights);
+    }
+#endif
+    return DotScalar(accumulator, weights);
+}
+
+static_assert(Evaluator::hidden % 16 == 0, "the SIMD kernel works on 16 units at a time");
+
+} // namespace
+
+Evaluator::Evaluator()
+{
+    SetDefaultWeights();
+}
+
+void Evaluator::SetDefaultWeights()
+{
+    // One unit per line, side and stone count k: the unit fires when the side has at least k
+    // stones on the line and the other side none. A stone weighs 42 and an opposing stone
+    // kills the line; the bias shifts the threshold to k.
+    constexpr int8_t stone = 42;
+    constexpr int8_t blocked = -128;
+    // Output weight per stone count, for the side that just moved and for its opponent:
+    // complete line, open two (a threat or a fork), open one (mobility)
+    constexpr std::array<int16_t, board_size> own_output{1, 20, 1000};
+    constexpr std::array<int16_t, board_size> opponent_output{-1, -300, -1000};
+
+    std::vector<std::array<uint8_t, board_size>> lines;
+    for (uint8_t i = 0; i < board_size; ++i) {
+        std::array<uint8_t, board_size> row{}, column{};
+        for (uint8_t j = 0; j < board_size; ++j) {
+            row[j] = i * board_size + j;
+            column[j] = j * board_size + i;
+        }
+        lines.push_back(row);
+        lines.push_back(column);
+    }
+    std::array<uint8_t, board_size> d1{}, d2{};
+    for (uint8_t i = 0; i < board_size; ++i) {
+        d1[i] = i * board_size + i;
+        d2[i] = i * board_size + board_size - 1 - i;
+    }
+    lines.push_back(d1);
+    lines.push_back(d2);
+
+    for (auto& column : m_weights) {
+        column.fill(0);
+    }
+    m_bias.fill(0);
+    m_output_weights.fill(0);
+
+    size_t unit = 0;
+    for (const auto& line : lines) {
+        for (bool own : {true, false}) {
+            for (uint8_t k = 1; k <= board_size && unit < hidden; ++k, ++unit) {
+                for (auto cell : line) {
+                    size_t offset = own ? 0 : board_size * board_size;
+                    m_weights[offset + cell][unit] = stone;
+                    m_weights[(board_size * board_size - offset) + cell][unit] = blocked;
+                }
+                m_bias[unit] = static_cast<int16_t>(-stone * (k - 1));
+                m_output_weights[unit] = own ? own_output[k - 1] : opponent_output[k - 1];
+            }
+        }
+    }
+
+    m_output_scale = 1.0f / stone;
+    m_output_bias = 0.0f;
+}
+
+bool Evaluator::Load(const std::string& path)
+{
+    std::ifstream file{path, std::ios::binary};
+    if (!file) {
+        return false;
+    }
+
+    auto read = [&file](void* data, size_t size) {
+        return static_cast<bool>(file.read(static_cast<char*>(data), size));
+    };
+
+    char magic[4];
+    uint32_t version = 0, file_inputs = 0, file_hidden = 0;
+    if (!read(magic, sizeof(magic)) || std::memcmp(magic, "TTTE", sizeof(magic)) != 0 ||
+        !read(&version, sizeof(version)) || version != 1 ||
+        !read(&file_inputs, sizeof(file_inputs)) || file_inputs != inputs ||
+        !read(&file_hidden, sizeof(file_hidden)) || file_hidden != hidden) {
+        return false;
+    }
+
+    // Read into a copy so a truncated file leaves the current weights untouched
+    Evaluator loaded;
+    for (auto& column : loaded.m_weights) {
+        if (!read(column.data(), hidden)) {
+            return false;
+        }
+    }
+    if (!read(loaded.m_bias.data(), hidden * sizeof(int16_t)) ||
+        !read(loaded.m_output_weights.data(), hidden * sizeof(int16_t)) ||
+        !read(&loaded.m_output_scale, sizeof(float)) ||
+        !read(&loaded.m_output_bias, sizeof(float))) {
+        return false;
+    }
+
+    *this = loaded;
+    return true;
+}
+
+void Evaluator::Refresh(const TicTacToeBoard& board, CellValue own,
+                        Accumulator& accumulator) const
+{
+    accumulator.values = m_bias;
+    for (uint8_t y = 0; y < board_size; ++y) {
+        for (uint8_t x = 0; x < board_size; ++x) {
+            auto value = board.At(x, y).value;
+            if (value != CellValue::None) {
+                AddStone(accumulator, value == own, x, y);
+            }
+        }
+    }
+}
+
+void Evaluator::AddStone(Accumulator& accumulator, bool own, uint8_t x, uint8_t y) const
+{
+    const auto& column = m_weights[Input(own, x, y)];
+    for (size_t i = 0; i < hidden; ++i) {
+        accumulator.values[i] = static_cast<int16_t>(accumulator.values[i] + column[i]);
+    }
+}
+
+void Evaluator::RemoveStone(Accumulator& accumulator, bool own, uint8_t x, uint8_t y) const
+{
+    const auto& column = m_weights[Input(own, x, y)];
+    for (size_t i = 0; i < hidden; ++i) {
+        accumulator.values[i] = static_cast<int16_t>(accumulator.values[i] - column[i]);
+    }
+}
+
+float Evaluator::Evaluate(const Accumulator& accumulator) const
+{
+    return Dot(accumulator.values.data(), m_output_weights.data()) * m_output_scale +
+           m_output_bias;
+}
+
+float Evaluator::EvaluateScalar(const Accumulator& accumulator) const
+{
+    return DotScalar(accumulator.values.data(), m_output_weights.data()) * m_output_scale +
+           m_output_bias;
+}
+
+bool Evaluator::HasSimdKernel()
+{
+#ifdef TICTACTOE_HAS_AVX2_KERNEL
+    return HasAvx2();
+#else
+    return false;
+#endif
+}
+
+//////////////////////////////
+
+namespace {
+
+Evaluator& SharedEvaluator()
+{
+    static Evaluator evaluator;
+    return evaluator;
+}
+
+} // namespace
+
+bool LearnedGamePolicy::LoadWeights(const std::string& path)
+{
+    return SharedEvaluator().Load(path);
+}
+
+void LearnedGamePolicy::OnStart(TicTacToeBoard& board)
+{
+    SharedEvaluator().Refresh(board, CellValue::X, m_accumulators[0]);
+    SharedEvaluator().Refresh(board, CellValue::O, m_accumulators[1]);
+}
+
+void LearnedGamePolicy::OnMove(const Cell& cell)
+{
+    const auto& evaluator = SharedEvaluator();
+    evaluator.AddStone(m_accumulators[0], cell.value == CellValue::X, cell.x, cell.y);
+    evaluator.AddStone(m_accumulators[1], cell.value == CellValue::O, cell.x, cell.y);
+}
+
+Cell* LearnedGamePolicy::ChooseCell(TicTacToeBoard& board, CellValue own)
+{
+    TICTACTOE_TRACE_SCOPE("LearnedGamePolicy::ChooseCell");
+    const auto& evaluator = SharedEvaluator();
+    auto accumulator = m_accumulators[own == CellValue::X ? 0 : 1];
+#ifndef NDEBUG
+    Evaluator::Accumulator refreshed;
+    evaluator.Refresh(board, own, refreshed);
+    assert(refreshed.values == accumulator.values);
+#endif
+
+    Cell* best = nullptr;
+    float best_score = 0.0f;
+    for (uint8_t y = 0; y < board_size; ++y) {
+        for (uint8_t x = 0; x < board_size; ++x) {
+            auto& cell = board.At(x, y);
+            if (cell.value != CellValue::None) {
+                continue;
+            }
+            // Score the position after the move, then take the move back
+            evaluator.AddStone(accumulator, true, x, y);
+            float score = evaluator.Evaluate(accumulator);
+            evaluator.RemoveStone(accumulator, true, x, y);
+            if (best == nullptr || score > best_score) {
+                best = &cell;
+                best_score = score;
+            }
+        }
+    }
+    return best;
+}
+
+} // namespace tictactoe
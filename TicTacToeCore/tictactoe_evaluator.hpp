@@ -0,0 +1,123 @@
+/// @file
+///
+/// @author
+///
+/// @copyright
+
+#ifndef TICTACTOE_EVALUATOR_HPP
+#define TICTACTOE_EVALUATOR_HPP
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include "tictactoecore_global.hpp"
+#include <tictactoe_board.hpp>
+
+namespace tictactoe {
+
+///
+/// \brief The Evaluator class, a tiny quantized two layer network over the occupancy planes
+///
+/// The inputs are two planes of board_size * board_size cells (stones of the side being
+/// evaluated, then the opponent's). As in NNUE, the first layer is kept as an accumulator of
+/// the int8 weight columns of the occupied inputs, so playing or undoing a stone only adds or
+/// subtracts one column. The output is the clipped accumulator dotted with int16 weights,
+/// scaled to a float score. The dot product runs through AVX2 when the CPU has it.
+///
+class TICTACTOECORESHARED_EXPORT Evaluator final {
+public:
+    /// Number of input features
+    static constexpr size_t inputs = 2 * board_size * board_size;
+    /// Number of hidden units, a multiple of 16 for the SIMD kernel
+    static constexpr size_t hidden = 48;
+    /// Upper bound of the clipped activation
+    static constexpr int16_t activation_max = 127;
+
+    ///
+    /// \brief The Accumulator struct, first layer output before the activation
+    ///
+    struct Accumulator {
+        std::array<int16_t, hidden> values;
+    };
+
+    ///
+    /// \brief Evaluator constructor, starts with the built-in weights
+    ///
+    Evaluator();
+
+    ///
+    /// \brief Load Replace the weights with the content of a weight file
+    ///
+    /// Little endian layout: "TTTE", uint32 version (1), uint32 inputs, uint32 hidden,
+    /// int8 first layer [inputs][hidden], int16 first layer bias [hidden],
+    /// int16 output weights [hidden], float output scale, float output bias.
+    /// \param path
+    /// \return False (and the weights unchanged) if the file is missing or malformed
+    ///
+    bool Load(const std::string& path);
+
+    ///
+    /// \brief Refresh Compute an accumulator from scratch
+    /// \param board
+    /// \param own Stones of the side being evaluated
+    /// \param accumulator
+    ///
+    void Refresh(const TicTacToeBoard& board, CellValue own, Accumulator& accumulator) const;
+
+    ///
+    /// \brief AddStone Incremental update for a stone placed on x, y
+    /// \param accumulator
+    /// \param own True for a stone of the side being evaluated
+    /// \param x
+    /// \param y
+    ///
+    void AddStone(Accumulator& accumulator, bool own, uint8_t x, uint8_t y) const;
+
+    ///
+    /// \brief RemoveStone Incremental update for a stone removed from x, y
+    /// \param accumulator
+    /// \param own True for a stone of the side being evaluated
+    /// \param x
+    /// \param y
+    ///
+    void RemoveStone(Accumulator& accumulator, bool own, uint8_t x, uint8_t y) const;
+
+    ///
+    /// \brief Evaluate Score of the position for the side being evaluated
+    /// \param accumulator
+    /// \return
+    ///
+    float Evaluate(const Accumulator& accumulator) const;
+
+    ///
+    /// \brief EvaluateScalar Same as Evaluate() through the portable kernel, to check the SIMD one
+    /// \param accumulator
+    /// \return
+    ///
+    float EvaluateScalar(const Accumulator& accumulator) const;
+
+    /// True if Evaluate() runs the AVX2 kernel on this CPU
+    static bool HasSimdKernel();
+
+private:
+    static size_t Input(bool own, uint8_t x, uint8_t y)
+    {
+        return (own ? 0 : board_size * board_size) + y * board_size + x;
+    }
+
+    ///
+    /// \brief SetDefaultWeights Hand-built weights detecting open lines (see the .cpp)
+    ///
+    void SetDefaultWeights();
+
+private:
+    alignas(32) std::array<std::array<int8_t, hidden>, inputs> m_weights;
+    alignas(32) std::array<int16_t, hidden> m_bias;
+    alignas(32) std::array<int16_t, hidden> m_output_weights;
+    float m_output_scale;
+    float m_output_bias;
+};
+
+} // namespace tictactoe
+
+#endif // TICTACTOE_EVALUATOR_HPP
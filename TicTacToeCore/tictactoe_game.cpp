@@ -5,123 +5,168 @@
 /// @copyright
 
 #include "tictactoe_game.hpp"
+#include "tictactoe_position.hpp"
+#include "tictactoe_search.hpp"
+#include "tictactoe_trace.hpp"
+#include <algorithm>
 #include <cassert>
-#include <cstdlib>
 #include <ctime>
 #include <stdexcept>
 
 namespace tictactoe {
 
-namespace {
-
-///
-/// \brief RandomNumber
-/// \param max
-/// \return
-///
-int RandomNumber(int max)
+void ConfiguredGamePolicy::UpdateAttackLinePoints(uint8_t enemy_count, uint8_t friendly_count,
+                                                  Cell& cell)
 {
-    std::srand(std::time(nullptr));
-    return std::rand() % max;
-}
-
-} // namespace
-
-///
-/// \brief The NormalGamePolicy class
-///
-class NormalGamePolicy : public GamePolicy {
-public:
-    void UpdateAttackLinePoints(uint8_t enemy_count, uint8_t friendly_count, Cell& cell) override
-    {
-        // Weaker attack
-        if (friendly_count == danger_zone) {
-            ++cell.attack_points;
-        }
-        // Some attack opportunities were lost because the enemy defended
-        else if (enemy_count < danger_zone) {
-            if (cell.attack_points > 0) {
-                --cell.attack_points;
-            }
+    const auto& parameters = *m_parameters;
+    if (friendly_count == danger_zone) {
+        auto points = parameters.win_attack_points;
+        if (parameters.win_attack_increment) {
+            // Stay below npos, which marks the winning line
+            points = static_cast<uint8_t>(
+                std::min(cell.attack_points + points, TicTacToeGame::npos - 1));
         }
+        cell.attack_points = points;
     }
-
-    void UpdateDefenseLinePoints(uint8_t enemy_count, Cell& cell) override
-    {
-        // Weaker defense
-        if (enemy_count > 0) {
-            cell.defense_points = 1;
-        }
+    else if (enemy_count < danger_zone) {
+        cell.attack_points = cell.attack_points > parameters.attack_decay
+                                 ? static_cast<uint8_t>(cell.attack_points - parameters.attack_decay)
+                                 : 0;
     }
-};
+}
 
-///
-/// \brief The ImpossibleGamePolicy class
-///
-class ImpossibleGamePolicy : public GamePolicy {
-public:
-    void UpdateAttackLinePoints(uint8_t enemy_count, uint8_t friendly_count, Cell& cell) override
-    {
-        // We have an opportunity to close the game, make sure it's taken
-        if (friendly_count == danger_zone) {
-            cell.attack_points = 20;
-        }
-        // Some attack opportunities were lost because the enemy defended
-        else if (enemy_count < danger_zone) {
-            if (cell.attack_points > 0) {
-                --cell.attack_points;
-            }
-        }
+void ConfiguredGamePolicy::UpdateDefenseLinePoints(uint8_t enemy_count, Cell& cell)
+{
+    const auto& parameters = *m_parameters;
+    if (enemy_count == danger_zone) {
+        cell.defense_points = parameters.danger_defense_points;
     }
+    else if (enemy_count > 0) {
+        cell.defense_points = static_cast<uint8_t>(std::min(
+            parameters.defense_points + parameters.defense_per_enemy * enemy_count,
+            TicTacToeGame::npos - 1));
+    }
+}
 
-    void UpdateDefenseLinePoints(uint8_t enemy_count, Cell& cell) override
-    {
-        // The higher the enemy count, the higher the defense
-        if (enemy_count > 0) {
-            cell.defense_points = enemy_count;
-            if (enemy_count == danger_zone) {
-                cell.defense_points = 10;
-            }
+void ConfiguredGamePolicy::SetKind(PolicyKind kind)
+{
+    assert(kind != PolicyKind::learned);
+    m_kind = kind;
+}
+
+void ConfiguredGamePolicy::OnStart(TicTacToeBoard& board)
+{
+    // Pinned until the next game: a Publish() during this one does not affect it
+    m_parameters = PolicyConfig::Current(m_kind);
+    for (uint8_t y = 0; y < board_size; ++y) {
+        for (uint8_t x = 0; x < board_size; ++x) {
+            board.At(x, y).attack_points = m_parameters->InitialAttackPoints(x, y);
         }
     }
-};
+}
 
 //////////////////////////////
 
 TicTacToeGame::TicTacToeGame()
-    : m_human_side{PlayerSide::os}
+    : m_policy{&m_point_policy}
+    , m_difficulty{PolicyKind::normal}
+    , m_human_side{PlayerSide::os}
     , m_current_player{PlayerType::human}
     , m_game_status{GameStatus::not_started}
     , m_moves{0u}
+    , m_changed_cells{0u}
+    , m_winning_line{0u}
+    , m_coalesce_updates{false}
+    , m_opening_x{npos}
+    , m_opening_y{npos}
+    , m_next_x{npos}
+    , m_next_y{npos}
+    , m_rng{static_cast<std::minstd_rand::result_type>(std::time(nullptr))}
 {
 }
 
+void TicTacToeGame::Seed(uint32_t seed)
+{
+    m_rng.seed(seed);
+}
+
+void TicTacToeGame::SetOpening(uint8_t x, uint8_t y)
+{
+    assert((x == npos && y == npos) || (x < board_size && y < board_size));
+    m_opening_x = x;
+    m_opening_y = y;
+}
+
+void TicTacToeGame::SetNextMove(uint8_t x, uint8_t y)
+{
+    assert(x < board_size && y < board_size);
+    m_next_x = x;
+    m_next_y = y;
+}
+
 void TicTacToeGame::Start(PlayerSide human_side, PlayerType first_player,
                           const GameUpdateCalback& callback, bool easy_mode)
 {
-    if (easy_mode) {
-        m_policy = std::make_unique<NormalGamePolicy>();
+    Start(human_side, first_player, callback,
+          easy_mode ? PolicyKind::normal : PolicyKind::impossible);
+}
+
+void TicTacToeGame::Start(PlayerSide human_side, PlayerType first_player,
+                          const GameUpdateCalback& callback, const Difficulty& difficulty)
+{
+    TICTACTOE_TRACE_SCOPE("TicTacToeGame::Start");
+    SetCallback(callback);
+    Restart(human_side, first_player, difficulty);
+}
+
+void TicTacToeGame::SetCallback(const GameUpdateCalback& callback)
+{
+    m_callback = callback;
+}
+
+void TicTacToeGame::Restart(PlayerSide human_side, PlayerType first_player, bool easy_mode)
+{
+    Restart(human_side, first_player, easy_mode ? PolicyKind::normal : PolicyKind::impossible);
+}
+
+void TicTacToeGame::Restart(PlayerSide human_side, PlayerType first_player,
+                            const Difficulty& difficulty)
+{
+    TICTACTOE_TRACE_SCOPE("TicTacToeGame::Restart");
+    m_difficulty = difficulty;
+    if (difficulty.policy == PolicyKind::learned) {
+        m_policy = &m_learned_policy;
     }
     else {
-        m_policy = std::make_unique<ImpossibleGamePolicy>();
+        m_point_policy.SetKind(difficulty.policy);
+        m_policy = &m_point_policy;
     }
-    m_board = TicTacToeBoard{};
+    m_board.Reset();
+    m_policy->OnStart(m_board);
     m_human_side = human_side;
     m_current_player = first_player;
-    m_callback = callback;
     m_game_status = GameStatus::in_progress;
     m_moves = 0;
+    m_next_x = npos;
+    m_next_y = npos;
+    // The whole board was reset
+    m_changed_cells = all_cells;
+    m_winning_line = 0;
 
     if (m_current_player == PlayerType::computer) {
         ComputerMove(true);
     }
-    else if (m_callback) {
-        m_callback(m_game_status);
-    }
+    Notify();
+}
+
+void TicTacToeGame::SetCoalesceUpdates(bool coalesce)
+{
+    m_coalesce_updates = coalesce;
 }
 
 void TicTacToeGame::HumanMove(uint8_t x, uint8_t y)
 {
+    TICTACTOE_TRACE_SCOPE("TicTacToeGame::HumanMove");
     assert(m_current_player == PlayerType::human);
     assert(m_board.At(x, y).value == CellValue::None);
 
@@ -136,26 +181,52 @@ void TicTacToeGame::HumanMove(uint8_t x, uint8_t y)
     UpdateGame(cell);
     // Computer's turn
     if (m_game_status == GameStatus::in_progress) {
+        if (!m_coalesce_updates) {
+            Notify();
+        }
         ComputerMove(false);
     }
+    Notify();
 }
 
 void TicTacToeGame::ComputerMove(bool first)
 {
+    TICTACTOE_TRACE_SCOPE("TicTacToeGame::ComputerMove");
     assert(m_current_player == PlayerType::computer);
 
     // First computer move
     if (first) {
-        auto x = RandomNumber(board_size);
-        auto y = RandomNumber(board_size);
+        auto x = (m_opening_x != npos) ? m_opening_x : RandomNumber(board_size);
+        auto y = (m_opening_y != npos) ? m_opening_y : RandomNumber(board_size);
         auto& cell = m_board.At(x, y);
         UpdateCell(cell, m_current_player);
         UpdateGame(cell);
         return;
     }
 
-    // Pick the one with the highest score
-    auto& cell = m_board.MaxScoreCell();
+    Cell* chosen = nullptr;
+    // Forced move
+    if (m_next_x != npos) {
+        chosen = &m_board.At(m_next_x, m_next_y);
+        assert(chosen->value == CellValue::None);
+        m_next_x = npos;
+        m_next_y = npos;
+    }
+    // Noise: a random move, without thinking
+    else if (m_difficulty.noise_percent > 0 &&
+             RandomNumber(100) < m_difficulty.noise_percent) {
+        chosen = &RandomEmptyCell();
+    }
+    // Let the policy choose, or pick the one with the highest score
+    else {
+        CellValue computer_pieces =
+            (m_human_side == PlayerSide::os) ? CellValue::X : CellValue::O;
+        chosen = m_policy->ChooseCell(m_board, computer_pieces);
+        if (m_difficulty.search_depth > 0) {
+            chosen = TacticalMove(chosen);
+        }
+    }
+    auto& cell = chosen ? *chosen : m_board.MaxScoreCell();
     // Mark the cell
     UpdateCell(cell, m_current_player);
     // Make another pass to see if our last move opened a win opportunity
@@ -164,8 +235,45 @@ void TicTacToeGame::ComputerMove(bool first)
     UpdateGame(cell);
 }
 
+Cell* TicTacToeGame::TacticalMove(Cell* chosen)
+{
+    auto key = Encode(m_board);
+    bool computer_xs = m_human_side == PlayerSide::os;
+    auto own = computer_xs ? XStones(key) : OStones(key);
+    auto opponent = computer_xs ? OStones(key) : XStones(key);
+    auto result = Search(own, opponent, m_difficulty.search_depth, m_difficulty.node_budget);
+
+    if (result.wins != 0) {
+        return &m_board.MaxScoreCell(result.wins);
+    }
+    // Everything loses: keep the policy move
+    if (result.safe == 0) {
+        return chosen;
+    }
+    auto& policy_cell = chosen ? *chosen : m_board.MaxScoreCell();
+    if (result.safe & CellBit(policy_cell.x, policy_cell.y)) {
+        return &policy_cell;
+    }
+    return &m_board.MaxScoreCell(result.safe);
+}
+
+Cell& TicTacToeGame::RandomEmptyCell()
+{
+    auto empty = static_cast<uint8_t>(board_size * board_size - m_moves);
+    auto n = RandomNumber(empty);
+    for (uint8_t y = 0;; ++y) {
+        for (uint8_t x = 0; x < board_size; ++x) {
+            auto& cell = m_board.At(x, y);
+            if (cell.value == CellValue::None && n-- == 0) {
+                return cell;
+            }
+        }
+    }
+}
+
 void TicTacToeGame::UpdateAttackPoints(uint8_t x, uint8_t y)
 {
+    TICTACTOE_TRACE_SCOPE("TicTacToeGame::UpdateAttackPoints");
     CellValue human_pieces = (m_human_side == PlayerSide::os) ? CellValue::O : CellValue::X;
     CellValue computer_pieces = (m_human_side == PlayerSide::os) ? CellValue::X : CellValue::O;
 
@@ -211,6 +319,7 @@ void TicTacToeGame::UpdateAttackPoints(uint8_t x, uint8_t y)
 
 void TicTacToeGame::UpdateDefensePoints(uint8_t x, uint8_t y)
 {
+    TICTACTOE_TRACE_SCOPE("TicTacToeGame::UpdateDefensePoints");
     CellValue human_pieces = (m_human_side == PlayerSide::os) ? CellValue::O : CellValue::X;
 
     // Count number of human pieces on the column
@@ -255,6 +364,7 @@ void TicTacToeGame::UpdateCell(Cell& cell, PlayerType player_type)
     cell.value = player_type == PlayerType::human ? human_pieces : computer_pieces;
     cell.attack_points = 0;
     cell.defense_points = 0;
+    m_policy->OnMove(cell);
 }
 
 void TicTacToeGame::UpdateGame(Cell& cell)
@@ -275,26 +385,49 @@ void TicTacToeGame::UpdateGame(Cell& cell)
     }
 
     ++m_moves;
+    m_changed_cells |= CellBit(cell.x, cell.y);
 
+    // Do we have a winner with the last move? It may complete a line on a full board
+    if (IsWinningMove(cell)) {
+        m_game_status = (player == PlayerSide::os) ? GameStatus::os_winner : GameStatus::xs_winner;
+    }
     // All moves consumed, no winner
-    if (m_moves == board_size * board_size) {
+    else if (m_moves == board_size * board_size) {
         m_game_status = GameStatus::draw;
     }
-    // Do we have a winner with the last move?
-    else if (IsWinningMove(cell)) {
-        m_game_status = (player == PlayerSide::os) ? GameStatus::os_winner : GameStatus::xs_winner;
-    }
+}
+
+void TicTacToeGame::Notify()
+{
+    GameUpdate update;
+    update.status = m_game_status;
+    update.changed_cells = m_changed_cells;
+    update.winning_line = m_winning_line;
+    update.side_to_move = (m_current_player == PlayerType::human)
+                              ? m_human_side
+                              : (m_human_side == PlayerSide::os) ? PlayerSide::xs : PlayerSide::os;
+    m_changed_cells = 0;
 
     if (m_callback) {
-        m_callback(m_game_status);
+        m_callback(update);
     }
 }
 
+uint8_t TicTacToeGame::RandomNumber(uint8_t max)
+{
+    // Plain modulo keeps the sequence identical across standard library implementations
+    return static_cast<uint8_t>(m_rng() % max);
+}
+
 bool TicTacToeGame::IsWinningMove(Cell& cell)
 {
+    TICTACTOE_TRACE_SCOPE("TicTacToeGame::IsWinningMove");
     assert(cell.value != CellValue::None);
 
-    auto mark_winner_cell = [](Cell& cell) { cell.attack_points = npos; };
+    auto mark_winner_cell = [this](Cell& cell) {
+        cell.attack_points = npos;
+        m_winning_line |= CellBit(cell.x, cell.y);
+    };
 
     // Check the column
     if (board_size == m_board.CountX(cell.x, cell.value)) {
@@ -7,10 +7,16 @@
 #ifndef TICTACTOE_GAME_HPP
 #define TICTACTOE_GAME_HPP
 
+#include <array>
 #include <functional>
+#include <limits>
 #include <memory>
+#include <random>
+#include <string_view>
 #include "tictactoecore_global.hpp"
 #include <tictactoe_board.hpp>
+#include <tictactoe_evaluator.hpp>
+#include <tictactoe_parameters.hpp>
 
 namespace tictactoe {
 
@@ -39,8 +45,153 @@ public:
     /// \param cell
     ///
     virtual void UpdateDefenseLinePoints(uint8_t enemy_count, Cell& cell) = 0;
+
+    ///
+    /// \brief ChooseCell Let the policy pick the computer move itself
+    /// \param board
+    /// \param own Computer pieces
+    /// \return The cell to play, or nullptr to play the highest scoring cell
+    ///
+    virtual Cell* ChooseCell(TicTacToeBoard& /*board*/, CellValue /*own*/) { return nullptr; }
+
+    ///
+    /// \brief OnStart Called on each new game, after the board reset
+    /// \param board
+    ///
+    virtual void OnStart(TicTacToeBoard& /*board*/) {}
+
+    ///
+    /// \brief OnMove Called after each stone is placed, by either player
+    /// \param cell
+    ///
+    virtual void OnMove(const Cell& /*cell*/) {}
+};
+
+///
+/// \brief The ConfiguredGamePolicy class, attack and defense points from PolicyParameters
+///
+/// Plays the normal, impossible and configured policies. Each game owns one. OnStart() pins
+/// the parameters published for the selected policy at that time (see PolicyConfig) and
+/// seeds the board with them; the moves then read the pinned copy.
+///
+class TICTACTOECORESHARED_EXPORT ConfiguredGamePolicy final : public GamePolicy {
+public:
+    ///
+    /// \brief SetKind Select the published parameters pinned by the next OnStart()
+    /// \param kind Any PolicyKind but learned
+    ///
+    void SetKind(PolicyKind kind);
+
+    void UpdateAttackLinePoints(uint8_t enemy_count, uint8_t friendly_count, Cell& cell) override;
+
+    void UpdateDefenseLinePoints(uint8_t enemy_count, Cell& cell) override;
+
+    void OnStart(TicTacToeBoard& board) override;
+
+private:
+    PolicyKind m_kind{PolicyKind::normal};
+    std::shared_ptr<const PolicyParameters> m_parameters;
+};
+
+///
+/// \brief The LearnedGamePolicy class plays the move with the best Evaluator score
+///
+/// Each game owns one. It keeps the first layer accumulators of the position seen from both
+/// sides: OnStart() computes them and each move adds one weight column, so a candidate move
+/// costs one incremental update and one dot product. The weights are shared by all the games.
+/// The attack and defense points are not used.
+///
+class TICTACTOECORESHARED_EXPORT LearnedGamePolicy final : public GamePolicy {
+public:
+    ///
+    /// \brief LoadWeights Load the evaluator weights used by every game from a file
+    ///
+    /// Call it at startup, before starting any game.
+    /// \param path
+    /// \return False (and the weights unchanged) if the file is missing or malformed
+    ///
+    static bool LoadWeights(const std::string& path);
+
+    void UpdateAttackLinePoints(uint8_t, uint8_t, Cell&) override {}
+
+    void UpdateDefenseLinePoints(uint8_t, Cell&) override {}
+
+    Cell* ChooseCell(TicTacToeBoard& board, CellValue own) override;
+
+    void OnStart(TicTacToeBoard& board) override;
+
+    void OnMove(const Cell& cell) override;
+
+private:
+    /// From the side of X, then of O
+    std::array<Evaluator::Accumulator, 2> m_accumulators;
 };
 
+///
+/// \brief The Difficulty struct, the strength of the computer player
+///
+/// A PolicyKind converts to the difficulty of that policy alone, without search nor noise.
+///
+struct Difficulty {
+    constexpr Difficulty(PolicyKind policy_kind = PolicyKind::normal, uint8_t depth = 0,
+                         uint32_t budget = 0, uint8_t noise = 0)
+        : policy{policy_kind}
+        , search_depth{depth}
+        , node_budget{budget}
+        , noise_percent{noise}
+    {
+    }
+
+    /// Scores the moves
+    PolicyKind policy;
+    /// Plies searched for forced wins and losses, which override the policy (0: no search)
+    uint8_t search_depth;
+    /// Search nodes per move
+    uint32_t node_budget;
+    /// Chance in percent of playing a random empty cell instead of thinking
+    uint8_t noise_percent;
+};
+
+///
+/// \brief The DifficultyLevel struct, a named difficulty
+///
+struct DifficultyLevel {
+    const char* name;
+    Difficulty difficulty;
+};
+
+///
+/// \brief difficulty_levels The levels offered to the players, from the easiest
+///
+/// The easy levels don't search, so they cost the least CPU. Strengths measured with
+/// TicTacToeTournament are in the README.
+///
+constexpr std::array<DifficultyLevel, 5> difficulty_levels{{
+    {"Beginner", {PolicyKind::normal, 0, 0, 50}},
+    {"Easy", {PolicyKind::normal}},
+    {"Medium", {PolicyKind::normal, 2, 64, 15}},
+    {"Hard", {PolicyKind::impossible}},
+    {"Expert", {PolicyKind::impossible, board_size * board_size, 1u << 20}},
+}};
+
+///
+/// \brief DifficultyIndex Index of a level in difficulty_levels
+/// \param name
+/// \return difficulty_levels.size() if there is no such level
+///
+constexpr size_t DifficultyIndex(std::string_view name)
+{
+    size_t i = 0;
+    while (i < difficulty_levels.size() && name != difficulty_levels[i].name) {
+        ++i;
+    }
+    return i;
+}
+
+/// Index in difficulty_levels of the level offered by default
+constexpr size_t default_difficulty = DifficultyIndex("Easy");
+static_assert(default_difficulty < difficulty_levels.size(), "unknown default difficulty");
+
 ///
 /// \brief The GameStatus enum
 ///
@@ -63,13 +214,54 @@ enum class PlayerSide { xs, os };
 enum class PlayerType { computer, human };
 
 ///
-/// \brief Callback used to notify the game status update to the UI
+/// \brief Cell set as a bit mask, bit y * board_size + x stands for cell x, y
+///
+using CellMask = uint16_t;
+
+static_assert(board_size * board_size <= 16, "CellMask is too small for the board");
+
+///
+/// \brief CellBit
+/// \param x
+/// \param y
+/// \return The mask bit of a cell
+///
+constexpr CellMask CellBit(uint8_t x, uint8_t y)
+{
+    return static_cast<CellMask>(1u << (y * board_size + x));
+}
+
+///
+/// \brief all_cells Mask of the whole board
+///
+constexpr CellMask all_cells = static_cast<CellMask>((1u << (board_size * board_size)) - 1);
+
+///
+/// \brief The GameUpdate struct, what changed since the previous notification
+///
+struct GameUpdate {
+    /// Game status
+    GameStatus status{GameStatus::not_started};
+    /// Cells changed since the previous update (all of them after Start)
+    CellMask changed_cells{0};
+    /// Cells of the winning line, if any
+    CellMask winning_line{0};
+    /// Who plays next
+    PlayerSide side_to_move{PlayerSide::xs};
+};
+
+///
+/// \brief Callback used to notify the game updates to the UI
 ///
-using GameUpdateCalback = std::function<void(GameStatus)>;
+using GameUpdateCalback = std::function<void(const GameUpdate&)>;
 
 ///
 /// \brief The TicTacToeGame class
 ///
+/// The board and the game state are stored inline, so the game takes no memory resource: to
+/// keep a session in an arena, place the game object itself there. The status callback is the
+/// only member that may reach the heap, and std::function takes no allocator.
+///
 class TICTACTOECORESHARED_EXPORT TicTacToeGame final {
 public:
     ///
@@ -112,6 +304,10 @@ public:
 
     ///
     /// \brief Start Starts a new game
+    ///
+    /// Neither Start() nor the moves allocate, except for copying a callback whose target
+    /// does not fit in the std::function small buffer (e.g. a lambda capturing more than a
+    /// couple of pointers).
     /// \param human_side X or O for the human?
     /// \param first_player Who goes first
     /// \param callback Game status update notification
@@ -120,6 +316,41 @@ public:
     void Start(PlayerSide human_side, PlayerType first_player, const GameUpdateCalback& callback,
                bool easy_mode);
 
+    ///
+    /// \brief Start Starts a new game at the given difficulty
+    /// \param human_side X or O for the human?
+    /// \param first_player Who goes first
+    /// \param callback Game status update notification
+    /// \param difficulty A PolicyKind or one of difficulty_levels
+    ///
+    void Start(PlayerSide human_side, PlayerType first_player, const GameUpdateCalback& callback,
+               const Difficulty& difficulty);
+
+    ///
+    /// \brief SetCallback Bind the game update notification without starting a game
+    /// \param callback
+    ///
+    void SetCallback(const GameUpdateCalback& callback);
+
+    ///
+    /// \brief Restart Starts a new game, keeping the callback bound by Start() or SetCallback()
+    ///
+    /// Cheaper than Start(): the board is restored from a precomputed image and the callback
+    /// is not copied. Meant for lobbies and tools running many games on one instance.
+    /// \param human_side X or O for the human?
+    /// \param first_player Who goes first
+    /// \param easy_mode Easy or difficult level
+    ///
+    void Restart(PlayerSide human_side, PlayerType first_player, bool easy_mode);
+
+    ///
+    /// \brief Restart Starts a new game at the given difficulty, keeping the callback
+    /// \param human_side X or O for the human?
+    /// \param first_player Who goes first
+    /// \param difficulty A PolicyKind or one of difficulty_levels
+    ///
+    void Restart(PlayerSide human_side, PlayerType first_player, const Difficulty& difficulty);
+
     ///
     /// \brief HumanMove Add position for human player
     /// \param x
@@ -127,6 +358,35 @@ public:
     ///
     void HumanMove(uint8_t x, uint8_t y);
 
+    ///
+    /// \brief SetCoalesceUpdates Notify a human move and the computer reply as a single update
+    /// \param coalesce
+    ///
+    void SetCoalesceUpdates(bool coalesce);
+
+    ///
+    /// \brief Seed Seed the random generator used by the computer, for reproducible games
+    /// \param seed
+    ///
+    void Seed(uint32_t seed);
+
+    ///
+    /// \brief SetOpening Force the first computer move of the next games, instead of a random one
+    /// \param x npos for a random move
+    /// \param y npos for a random move
+    ///
+    void SetOpening(uint8_t x, uint8_t y);
+
+    ///
+    /// \brief SetNextMove Force the next computer reply of the current game, e.g. from an
+    /// opening book
+    ///
+    /// The computer plays the cell without thinking nor noise. Restart() clears it.
+    /// \param x
+    /// \param y
+    ///
+    void SetNextMove(uint8_t x, uint8_t y);
+
     ///
     /// \brief GetCell Getter for the board cells
     /// \param x
@@ -142,6 +402,20 @@ private:
     ///
     void ComputerMove(bool first);
 
+    ///
+    /// \brief TacticalMove Check the move of the policy with a search
+    /// \param chosen Cell chosen by the policy, nullptr for the highest scoring cell
+    /// \return The highest scoring winning cell if any, else the policy cell if it does not
+    /// lose, else the highest scoring cell that does not lose
+    ///
+    Cell* TacticalMove(Cell* chosen);
+
+    ///
+    /// \brief RandomEmptyCell
+    /// \return
+    ///
+    Cell& RandomEmptyCell();
+
     ///
     /// \brief UpdateAttackPoints Update attack scores starting from x, y
     /// \param x
@@ -163,11 +437,16 @@ private:
     void UpdateCell(Cell& cell, PlayerType player);
 
     ///
-    /// \brief UpdateGame Update game data and status and notify
+    /// \brief UpdateGame Update game data and status
     /// \param cell
     ///
     void UpdateGame(Cell& cell);
 
+    ///
+    /// \brief Notify Send the changes accumulated since the last update to the callback
+    ///
+    void Notify();
+
     ///
     /// \brief IsWinningMove Check if last move is a game winner
     /// \param cell
@@ -175,14 +454,35 @@ private:
     ///
     bool IsWinningMove(Cell& cell);
 
+    ///
+    /// \brief RandomNumber
+    /// \param max
+    /// \return A number in [0, max)
+    ///
+    uint8_t RandomNumber(uint8_t max);
+
 private:
-    std::unique_ptr<GamePolicy> m_policy;
+    GamePolicy* m_policy;
+    /// Plays every policy but the learned one
+    ConfiguredGamePolicy m_point_policy;
+    LearnedGamePolicy m_learned_policy;
+    Difficulty m_difficulty;
     TicTacToeBoard m_board;
     PlayerSide m_human_side;
     PlayerType m_current_player;
     GameUpdateCalback m_callback;
     GameStatus m_game_status;
     size_t m_moves;
+    CellMask m_changed_cells;
+    CellMask m_winning_line;
+    bool m_coalesce_updates;
+    uint8_t m_opening_x;
+    uint8_t m_opening_y;
+    uint8_t m_next_x;
+    uint8_t m_next_y;
+    /// Small generator: it is only used for the first computer move, and idle sessions pay
+    /// for its state
+    std::minstd_rand m_rng;
 };
 
 } // namespace tictactoe
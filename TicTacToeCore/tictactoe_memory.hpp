@@ -0,0 +1,73 @@
+/// @file
+///
+/// @author
+///
+/// @copyright
+
+#ifndef TICTACTOE_MEMORY_HPP
+#define TICTACTOE_MEMORY_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <memory_resource>
+
+namespace tictactoe {
+
+///
+/// \brief The CountingMemoryResource class
+///
+/// Forwards to an upstream resource and counts the calls, to check in tests that a code path
+/// does not allocate (or allocates only from the expected arena).
+///
+class CountingMemoryResource final : public std::pmr::memory_resource {
+public:
+    ///
+    /// \brief CountingMemoryResource constructor
+    /// \param upstream Resource doing the actual allocations
+    ///
+    explicit CountingMemoryResource(
+        std::pmr::memory_resource* upstream = std::pmr::get_default_resource())
+        : m_upstream{upstream}
+    {
+    }
+
+    /// Number of allocations so far
+    size_t Allocations() const { return m_allocations.load(std::memory_order_relaxed); }
+
+    /// Number of bytes allocated so far
+    size_t Bytes() const { return m_bytes.load(std::memory_order_relaxed); }
+
+    /// Reset the counters
+    void Reset()
+    {
+        m_allocations.store(0, std::memory_order_relaxed);
+        m_bytes.store(0, std::memory_order_relaxed);
+    }
+
+private:
+    void* do_allocate(std::size_t bytes, std::size_t alignment) override
+    {
+        m_allocations.fetch_add(1, std::memory_order_relaxed);
+        m_bytes.fetch_add(bytes, std::memory_order_relaxed);
+        return m_upstream->allocate(bytes, alignment);
+    }
+
+    void do_deallocate(void* p, std::size_t bytes, std::size_t alignment) override
+    {
+        m_upstream->deallocate(p, bytes, alignment);
+    }
+
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override
+    {
+        return this == &other;
+    }
+
+private:
+    std::pmr::memory_resource* m_upstream;
+    std::atomic<size_t> m_allocations{0};
+    std::atomic<size_t> m_bytes{0};
+};
+
+} // namespace tictactoe
+
+#endif // TICTACTOE_MEMORY_HPP
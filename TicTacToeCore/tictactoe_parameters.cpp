@@ -0,0 +1,169 @@
+/// @file
+///
+/// @author
+///
+/// @copyright
+
+#include "tictactoe_parameters.hpp"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <fstream>
+#include <istream>
+#include <sstream>
+#include <stdexcept>
+
+namespace tictactoe {
+
+namespace {
+
+///
+/// \brief The Field struct maps a configuration key to a parameter
+///
+struct Field {
+    const char* key;
+    uint8_t PolicyParameters::*points;
+    bool PolicyParameters::*flag;
+};
+
+const std::array<Field, 9> fields{{
+    {"win_attack_points", &PolicyParameters::win_attack_points, nullptr},
+    {"win_attack_increment", nullptr, &PolicyParameters::win_attack_increment},
+    {"attack_decay", &PolicyParameters::attack_decay, nullptr},
+    {"defense_points", &PolicyParameters::defense_points, nullptr},
+    {"defense_per_enemy", &PolicyParameters::defense_per_enemy, nullptr},
+    {"danger_defense_points", &PolicyParameters::danger_defense_points, nullptr},
+    {"corner_attack_points", &PolicyParameters::corner_attack_points, nullptr},
+    {"side_attack_points", &PolicyParameters::side_attack_points, nullptr},
+    {"center_attack_points", &PolicyParameters::center_attack_points, nullptr},
+}};
+
+/// Points stay below TicTacToeGame::npos, which marks the winning line
+constexpr unsigned long max_points = 254;
+
+#if defined(__cpp_lib_atomic_shared_ptr)
+using Snapshot = std::atomic<std::shared_ptr<const PolicyParameters>>;
+#else
+using Snapshot = std::shared_ptr<const PolicyParameters>;
+#endif
+
+Snapshot& Published(PolicyKind kind)
+{
+    // Indexed by PolicyKind, the learned slot is never used
+    static std::array<Snapshot, 4> snapshots{
+        std::make_shared<const PolicyParameters>(PolicyParameters::Normal()),
+        std::make_shared<const PolicyParameters>(PolicyParameters::Impossible()),
+        nullptr,
+        std::make_shared<const PolicyParameters>(PolicyParameters::Normal()),
+    };
+    if (kind == PolicyKind::learned) {
+        throw std::invalid_argument{"the learned policy has no parameters"};
+    }
+    return snapshots[static_cast<size_t>(kind)];
+}
+
+std::shared_ptr<const PolicyParameters> Load(PolicyKind kind)
+{
+#if defined(__cpp_lib_atomic_shared_ptr)
+    return Published(kind).load();
+#else
+    return std::atomic_load(&Published(kind));
+#endif
+}
+
+void Store(PolicyKind kind, std::shared_ptr<const PolicyParameters> parameters)
+{
+#if defined(__cpp_lib_atomic_shared_ptr)
+    Published(kind).store(std::move(parameters));
+#else
+    std::atomic_store(&Published(kind), std::move(parameters));
+#endif
+}
+
+} // namespace
+
+bool PolicyParameters::Read(std::istream& in, std::string* error)
+{
+    auto fail = [error](const std::string& reason) {
+        if (error) {
+            *error = reason;
+        }
+        return false;
+    };
+
+    // Parse into a copy so a bad line leaves the parameters untouched
+    PolicyParameters parsed = *this;
+    std::string text;
+    size_t line = 0;
+    while (std::getline(in, text)) {
+        ++line;
+        std::istringstream tokens{text};
+        std::string key, value, extra;
+        if (!(tokens >> key) || key[0] == '#') {
+            continue;
+        }
+
+        auto field = std::find_if(fields.begin(), fields.end(),
+                                  [&key](const Field& f) { return key == f.key; });
+        if (field == fields.end()) {
+            return fail("line " + std::to_string(line) + ": unknown key " + key);
+        }
+        unsigned long number = 0;
+        size_t end = 0;
+        try {
+            tokens >> value;
+            number = std::stoul(value, &end);
+        }
+        catch (const std::logic_error&) {
+            end = 0;
+        }
+        auto max = field->flag ? 1ul : max_points;
+        if (end == 0 || end != value.size() || number > max || (tokens >> extra)) {
+            return fail("line " + std::to_string(line) + ": invalid value for " + key);
+        }
+
+        if (field->flag) {
+            parsed.*(field->flag) = number != 0;
+        }
+        else {
+            parsed.*(field->points) = static_cast<uint8_t>(number);
+        }
+    }
+
+    *this = parsed;
+    return true;
+}
+
+bool PolicyParameters::Load(const std::string& path, std::string* error)
+{
+    std::ifstream file{path};
+    if (!file) {
+        if (error) {
+            *error = "cannot open " + path;
+        }
+        return false;
+    }
+    return Read(file, error);
+}
+
+std::shared_ptr<const PolicyParameters> PolicyConfig::Current(PolicyKind kind)
+{
+    return Load(kind);
+}
+
+void PolicyConfig::Publish(const PolicyParameters& parameters, PolicyKind kind)
+{
+    Store(kind, std::make_shared<const PolicyParameters>(parameters));
+}
+
+bool PolicyConfig::Reload(const std::string& path, std::string* error, PolicyKind kind)
+{
+    PolicyParameters parameters = *Current(kind);
+    if (!parameters.Load(path, error)) {
+        return false;
+    }
+    Publish(parameters, kind);
+    return true;
+}
+
+} // namespace tictactoe
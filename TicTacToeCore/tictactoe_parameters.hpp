@@ -0,0 +1,150 @@
+/// @file
+///
+/// @author
+///
+/// @copyright
+
+#ifndef TICTACTOE_PARAMETERS_HPP
+#define TICTACTOE_PARAMETERS_HPP
+
+#include <cstdint>
+#include <iosfwd>
+#include <memory>
+#include <string>
+#include "tictactoecore_global.hpp"
+#include <tictactoe_board.hpp>
+
+namespace tictactoe {
+
+///
+/// \brief The PolicyKind enum, the available computer strategies
+///
+/// All but the learned one play the attack/defense point rules with the PolicyParameters
+/// published for them (see PolicyConfig).
+///
+enum class PolicyKind {
+    normal,     ///< Easy mode, conservative attack points
+    impossible, ///< Hard mode, aims to be unbeatable
+    learned,    ///< Learned evaluator (see LearnedGamePolicy)
+    configured, ///< Parameters tuned at run time, the normal ones until published
+};
+
+///
+/// \brief The PolicyParameters struct, the weights of the attack/defense point policy
+///
+/// Each empty cell of a line touched by a move is updated as follows, with the stones counted
+/// after the move:
+/// - attack: with danger_zone computer stones on the line, set to win_attack_points (or add
+///   it when win_attack_increment); otherwise, with less than danger_zone human stones,
+///   subtract attack_decay (down to 0)
+/// - defense (after human moves only): with danger_zone human stones, set to
+///   danger_defense_points; otherwise, with any human stone, set to
+///   defense_points + defense_per_enemy * human stones
+///
+/// The defaults are the normal (easy) policy.
+///
+struct TICTACTOECORESHARED_EXPORT PolicyParameters {
+    uint8_t win_attack_points{1};
+    bool win_attack_increment{true};
+    uint8_t attack_decay{1};
+    uint8_t defense_points{1};
+    uint8_t defense_per_enemy{0};
+    uint8_t danger_defense_points{1};
+    /// Initial attack points of the empty board
+    uint8_t corner_attack_points{3};
+    uint8_t side_attack_points{2};
+    uint8_t center_attack_points{4};
+
+    ///
+    /// \brief InitialAttackPoints Attack points of a cell of the empty board
+    /// \param x
+    /// \param y
+    /// \return
+    ///
+    constexpr uint8_t InitialAttackPoints(uint8_t x, uint8_t y) const
+    {
+        bool corner = (x == 0 || x == board_size - 1) && (y == 0 || y == board_size - 1);
+        bool center = board_size % 2 == 1 && x == board_size / 2 && y == board_size / 2;
+        return corner ? corner_attack_points : center ? center_attack_points : side_attack_points;
+    }
+
+    /// The built-in weights of PolicyKind::normal
+    static constexpr PolicyParameters Normal() { return {}; }
+
+    /// The built-in weights of PolicyKind::impossible
+    static constexpr PolicyParameters Impossible()
+    {
+        PolicyParameters parameters;
+        parameters.win_attack_points = 20;
+        parameters.win_attack_increment = false;
+        parameters.defense_points = 0;
+        parameters.defense_per_enemy = 1;
+        parameters.danger_defense_points = 10;
+        return parameters;
+    }
+
+    ///
+    /// \brief Read Parse a configuration
+    ///
+    /// One "key value" pair per line, keys named after the fields, booleans as 0 or 1, lines
+    /// starting with # are comments. Missing keys keep their current value.
+    /// \param in
+    /// \param error Set to the reason of a failure, if not null
+    /// \return False (and the parameters unchanged) on an unknown key or invalid value
+    ///
+    bool Read(std::istream& in, std::string* error = nullptr);
+
+    ///
+    /// \brief Load Read a configuration file
+    /// \param path
+    /// \param error Set to the reason of a failure, if not null
+    /// \return False (and the parameters unchanged) if the file is missing or malformed
+    ///
+    bool Load(const std::string& path, std::string* error = nullptr);
+};
+
+///
+/// \brief The PolicyConfig class, the parameters published for each point based PolicyKind
+///
+/// Read-copy-update: Publish() swaps in an immutable snapshot, and each game pins the current
+/// snapshot of its policy when it starts, then plays its moves from it without any
+/// synchronization. Games in progress keep their snapshot until they end, new games pick up
+/// the new one. A snapshot is freed when the last game using it restarts.
+///
+/// Until the first Publish(), normal and configured play PolicyParameters::Normal() and
+/// impossible plays PolicyParameters::Impossible(). PolicyKind::learned has no parameters:
+/// naming it throws std::invalid_argument.
+///
+class TICTACTOECORESHARED_EXPORT PolicyConfig final {
+public:
+    ///
+    /// \brief Current The latest parameters published for a policy
+    /// \param kind
+    /// \return
+    ///
+    static std::shared_ptr<const PolicyParameters>
+    Current(PolicyKind kind = PolicyKind::configured);
+
+    ///
+    /// \brief Publish Make the parameters used by the games of a policy started from now on
+    /// \param parameters
+    /// \param kind
+    ///
+    static void Publish(const PolicyParameters& parameters,
+                        PolicyKind kind = PolicyKind::configured);
+
+    ///
+    /// \brief Reload Load a configuration file over the current parameters of a policy and
+    /// publish it
+    /// \param path
+    /// \param error Set to the reason of a failure, if not null
+    /// \param kind
+    /// \return False (and nothing published) if the file is missing or malformed
+    ///
+    static bool Reload(const std::string& path, std::string* error = nullptr,
+                       PolicyKind kind = PolicyKind::configured);
+};
+
+} // namespace tictactoe
+
+#endif // TICTACTOE_PARAMETERS_HPP
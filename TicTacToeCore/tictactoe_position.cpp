@@ -0,0 +1,263 @@
+/// @file
+///
+/// @author
+///
+/// @copyright
+
+#include "tictactoe_position.hpp"
+#include <array>
+#include <cassert>
+
+namespace tictactoe {
+
+namespace {
+
+// Symmetries and base 3 conversions are table lookups on halves of the masks: the tables are
+// small enough to stay in L1, and unlike pext/pdep they need no particular instruction set.
+
+constexpr uint8_t cell_count = board_size * board_size;
+
+/// The masks are transformed in two halves, one table lookup each
+constexpr uint8_t low_bits = cell_count - cell_count / 2;
+constexpr uint8_t high_bits = cell_count / 2;
+
+/// Base 3 keys are decoded in two groups of digits, one table lookup each
+constexpr uint8_t low_digits = cell_count / 2;
+constexpr uint8_t high_digits = cell_count - low_digits;
+
+constexpr uint32_t Pow3(uint8_t n)
+{
+    uint32_t result = 1;
+    for (uint8_t i = 0; i < n; ++i) {
+        result *= 3;
+    }
+    return result;
+}
+
+using Permutation = std::array<uint8_t, cell_count>;
+
+///
+/// \brief Permutations Destination of every cell for each symmetry
+///
+constexpr std::array<Permutation, symmetry_count> Permutations()
+{
+    std::array<Permutation, symmetry_count> permutations{};
+    for (uint8_t s = 0; s < symmetry_count; ++s) {
+        for (uint8_t y = 0; y < board_size; ++y) {
+            for (uint8_t x = 0; x < board_size; ++x) {
+                uint8_t tx = x, ty = y;
+                for (uint8_t r = 0; r < s % 4; ++r) {
+                    uint8_t rx = board_size - 1 - ty;
+                    ty = tx;
+                    tx = rx;
+                }
+                if (s >= 4) {
+                    tx = board_size - 1 - tx;
+                }
+                permutations[s][y * board_size + x] = ty * board_size + tx;
+            }
+        }
+    }
+    return permutations;
+}
+
+constexpr auto permutations = Permutations();
+
+///
+/// \brief Inverses Symmetry undoing each symmetry
+///
+constexpr std::array<uint8_t, symmetry_count> Inverses()
+{
+    std::array<uint8_t, symmetry_count> inverses{};
+    for (uint8_t s = 0; s < symmetry_count; ++s) {
+        for (uint8_t t = 0; t < symmetry_count; ++t) {
+            bool identity = true;
+            for (uint8_t i = 0; i < cell_count; ++i) {
+                identity = identity && permutations[t][permutations[s][i]] == i;
+            }
+            if (identity) {
+                inverses[s] = t;
+            }
+        }
+    }
+    return inverses;
+}
+
+constexpr auto inverses = Inverses();
+
+template <uint8_t Bits>
+using MaskTable = std::array<std::array<CellMask, 1u << Bits>, symmetry_count>;
+
+///
+/// \brief MakeMaskTable Images of every pattern of Bits cells starting at cell first
+///
+template <uint8_t Bits>
+constexpr MaskTable<Bits> MakeMaskTable(uint8_t first)
+{
+    MaskTable<Bits> table{};
+    for (uint8_t s = 0; s < symmetry_count; ++s) {
+        for (uint32_t pattern = 0; pattern < (1u << Bits); ++pattern) {
+            CellMask image = 0;
+            for (uint8_t i = 0; i < Bits; ++i) {
+                if (pattern & (1u << i)) {
+                    image |= static_cast<CellMask>(1u << permutations[s][first + i]);
+                }
+            }
+            table[s][pattern] = image;
+        }
+    }
+    return table;
+}
+
+constexpr auto low_masks = MakeMaskTable<low_bits>(0);
+constexpr auto high_masks = MakeMaskTable<high_bits>(low_bits);
+
+///
+/// \brief TernaryDigits Base 3 value of every cell mask with the digits set to 1
+///
+constexpr std::array<TernaryKey, 1u << cell_count> TernaryDigits()
+{
+    std::array<TernaryKey, 1u << cell_count> digits{};
+    for (uint32_t mask = 0; mask < (1u << cell_count); ++mask) {
+        uint32_t value = 0;
+        for (uint8_t i = 0; i < cell_count; ++i) {
+            if (mask & (1u << i)) {
+                value += Pow3(i);
+            }
+        }
+        digits[mask] = static_cast<TernaryKey>(value);
+    }
+    return digits;
+}
+
+constexpr auto ternary_digits = TernaryDigits();
+
+///
+/// \brief TernaryKeys Keys of every group of Digits base 3 digits starting at cell first
+///
+template <uint8_t Digits>
+constexpr std::array<PositionKey, Pow3(Digits)> TernaryKeys(uint8_t first)
+{
+    std::array<PositionKey, Pow3(Digits)> keys{};
+    for (uint32_t value = 0; value < Pow3(Digits); ++value) {
+        CellMask x_stones = 0, o_stones = 0;
+        uint32_t rest = value;
+        for (uint8_t i = 0; i < Digits; ++i, rest /= 3) {
+            if (rest % 3 == 1) {
+                x_stones |= static_cast<CellMask>(1u << (first + i));
+            }
+            else if (rest % 3 == 2) {
+                o_stones |= static_cast<CellMask>(1u << (first + i));
+            }
+        }
+        keys[value] = MakeKey(x_stones, o_stones);
+    }
+    return keys;
+}
+
+constexpr auto low_ternary_keys = TernaryKeys<low_digits>(0);
+constexpr auto high_ternary_keys = TernaryKeys<high_digits>(low_digits);
+
+///
+/// \brief EncodeCells Key of the stones given by a cell accessor
+/// \param cell_at Callable returning the cell at x, y
+///
+template <typename CellAt>
+PositionKey EncodeCells(const CellAt& cell_at)
+{
+    CellMask x_stones = 0, o_stones = 0;
+    for (uint8_t y = 0; y < board_size; ++y) {
+        for (uint8_t x = 0; x < board_size; ++x) {
+            auto value = cell_at(x, y).value;
+            if (value == CellValue::X) {
+                x_stones |= CellBit(x, y);
+            }
+            else if (value == CellValue::O) {
+                o_stones |= CellBit(x, y);
+            }
+        }
+    }
+    return MakeKey(x_stones, o_stones);
+}
+
+} // namespace
+
+PositionKey Encode(const TicTacToeBoard& board)
+{
+    return EncodeCells([&board](uint8_t x, uint8_t y) -> const Cell& { return board.At(x, y); });
+}
+
+PositionKey Encode(const TicTacToeGame& game)
+{
+    return EncodeCells(
+        [&game](uint8_t x, uint8_t y) -> const Cell& { return game.GetCell(x, y); });
+}
+
+void Decode(PositionKey key, TicTacToeBoard& board)
+{
+    assert((XStones(key) & OStones(key)) == 0);
+    for (uint8_t y = 0; y < board_size; ++y) {
+        for (uint8_t x = 0; x < board_size; ++x) {
+            auto bit = CellBit(x, y);
+            board.At(x, y).value = (XStones(key) & bit)   ? CellValue::X
+                                   : (OStones(key) & bit) ? CellValue::O
+                                                          : CellValue::None;
+        }
+    }
+}
+
+TernaryKey ToTernary(PositionKey key)
+{
+    return static_cast<TernaryKey>(ternary_digits[XStones(key)] +
+                                   2 * ternary_digits[OStones(key)]);
+}
+
+PositionKey FromTernary(TernaryKey key)
+{
+    assert(key < Pow3(cell_count));
+    return low_ternary_keys[key % Pow3(low_digits)] |
+           high_ternary_keys[key / Pow3(low_digits)];
+}
+
+uint8_t TransformCell(uint8_t cell, uint8_t symmetry)
+{
+    assert(cell < cell_count && symmetry < symmetry_count);
+    return permutations[symmetry][cell];
+}
+
+uint8_t InverseSymmetry(uint8_t symmetry)
+{
+    assert(symmetry < symmetry_count);
+    return inverses[symmetry];
+}
+
+CellMask TransformMask(CellMask mask, uint8_t symmetry)
+{
+    assert(symmetry < symmetry_count);
+    return low_masks[symmetry][mask & ((1u << low_bits) - 1)] |
+           high_masks[symmetry][(mask >> low_bits) & ((1u << high_bits) - 1)];
+}
+
+PositionKey TransformKey(PositionKey key, uint8_t symmetry)
+{
+    return MakeKey(TransformMask(XStones(key), symmetry), TransformMask(OStones(key), symmetry));
+}
+
+PositionKey CanonicalKey(PositionKey key, uint8_t* symmetry)
+{
+    PositionKey best = key;
+    uint8_t best_symmetry = 0;
+    for (uint8_t s = 1; s < symmetry_count; ++s) {
+        auto transformed = TransformKey(key, s);
+        if (transformed < best) {
+            best = transformed;
+            best_symmetry = s;
+        }
+    }
+    if (symmetry != nullptr) {
+        *symmetry = best_symmetry;
+    }
+    return best;
+}
+
+} // namespace tictactoe
@@ -0,0 +1,145 @@
+/// @file
+///
+/// @author
+///
+/// @copyright
+
+#ifndef TICTACTOE_POSITION_HPP
+#define TICTACTOE_POSITION_HPP
+
+#include <cstdint>
+#include "tictactoecore_global.hpp"
+#include <tictactoe_game.hpp>
+
+namespace tictactoe {
+
+///
+/// \brief Packed position: X stones in the low 16 bits, O stones in the high 16 bits
+///
+/// Any two disjoint cell masks pack the same way, e.g. the stones of the side to move and of
+/// its opponent. Keys of the same kind compare and hash as plain integers.
+///
+using PositionKey = uint32_t;
+
+///
+/// \brief Base 3 position, digit y * board_size + x is 0 (empty), 1 (X) or 2 (O)
+///
+/// The densest encoding (3^9 values): use it to index tables or in network payloads.
+///
+using TernaryKey = uint16_t;
+
+static_assert(board_size * board_size <= 10, "TernaryKey is too small for the board");
+
+///
+/// \brief symmetry_count The 4 rotations of the board and their mirrors
+///
+constexpr uint8_t symmetry_count = 8;
+
+///
+/// \brief MakeKey
+/// \param x_stones
+/// \param o_stones
+/// \return
+///
+constexpr PositionKey MakeKey(CellMask x_stones, CellMask o_stones)
+{
+    return static_cast<PositionKey>(x_stones) | (static_cast<PositionKey>(o_stones) << 16);
+}
+
+/// X stones of a key
+constexpr CellMask XStones(PositionKey key)
+{
+    return static_cast<CellMask>(key);
+}
+
+/// O stones of a key
+constexpr CellMask OStones(PositionKey key)
+{
+    return static_cast<CellMask>(key >> 16);
+}
+
+///
+/// \brief Encode Key of the stones on a board
+/// \param board
+/// \return
+///
+TICTACTOECORESHARED_EXPORT PositionKey Encode(const TicTacToeBoard& board);
+
+///
+/// \brief Encode Key of the stones of a game
+/// \param game
+/// \return
+///
+TICTACTOECORESHARED_EXPORT PositionKey Encode(const TicTacToeGame& game);
+
+///
+/// \brief Decode Set the cell values of a board from a key
+///
+/// Only the values are written: the attack and defense points are engine state, not part of
+/// the position.
+/// \param key
+/// \param board
+///
+TICTACTOECORESHARED_EXPORT void Decode(PositionKey key, TicTacToeBoard& board);
+
+///
+/// \brief ToTernary
+/// \param key
+/// \return
+///
+TICTACTOECORESHARED_EXPORT TernaryKey ToTernary(PositionKey key);
+
+///
+/// \brief FromTernary
+/// \param key
+/// \return
+///
+TICTACTOECORESHARED_EXPORT PositionKey FromTernary(TernaryKey key);
+
+///
+/// \brief TransformCell Image of a cell index by a symmetry
+///
+/// Symmetry s rotates the board s % 4 quarter turns, then mirrors it left to right if s >= 4.
+/// \param cell y * board_size + x
+/// \param symmetry
+/// \return
+///
+TICTACTOECORESHARED_EXPORT uint8_t TransformCell(uint8_t cell, uint8_t symmetry);
+
+///
+/// \brief InverseSymmetry
+/// \param symmetry
+/// \return The symmetry mapping the images of symmetry back
+///
+TICTACTOECORESHARED_EXPORT uint8_t InverseSymmetry(uint8_t symmetry);
+
+///
+/// \brief TransformMask Image of a cell mask by a symmetry
+/// \param mask
+/// \param symmetry
+/// \return
+///
+TICTACTOECORESHARED_EXPORT CellMask TransformMask(CellMask mask, uint8_t symmetry);
+
+///
+/// \brief TransformKey Image of a position by a symmetry
+/// \param key
+/// \param symmetry
+/// \return
+///
+TICTACTOECORESHARED_EXPORT PositionKey TransformKey(PositionKey key, uint8_t symmetry);
+
+///
+/// \brief CanonicalKey The smallest key among the symmetric positions
+///
+/// Symmetric positions share the same canonical key. To map a move of the canonical position
+/// back to the original one, use TransformCell(move, InverseSymmetry(*symmetry)).
+/// \param key
+/// \param symmetry If not null, receives the symmetry mapping key to the canonical key
+/// \return
+///
+TICTACTOECORESHARED_EXPORT PositionKey CanonicalKey(PositionKey key, uint8_t* symmetry = nullptr);
+
+} // namespace tictactoe
+
+#endif // TICTACTOE_POSITION_HPP
@@ -0,0 +1,141 @@
+/// @file
+///
+/// @author
+///
+/// @copyright
+
+#include "tictactoe_search.hpp"
+#include "tictactoe_cache.hpp"
+#include "tictactoe_trace.hpp"
+#include <array>
+
+namespace tictactoe {
+
+namespace {
+
+constexpr uint8_t line_count = 2 * board_size + 2;
+
+///
+/// \brief Lines The winning lines as cell masks: columns, rows, then the diagonals
+///
+constexpr std::array<CellMask, line_count> Lines()
+{
+    std::array<CellMask, line_count> lines{};
+    for (uint8_t i = 0; i < board_size; ++i) {
+        for (uint8_t j = 0; j < board_size; ++j) {
+            lines[i] |= CellBit(i, j);
+            lines[board_size + i] |= CellBit(j, i);
+        }
+        lines[2 * board_size] |= CellBit(i, i);
+        lines[2 * board_size + 1] |= CellBit(i, board_size - 1 - i);
+    }
+    return lines;
+}
+
+constexpr auto lines = Lines();
+
+///
+/// \brief The Searcher class, the state of one search
+///
+class Searcher {
+public:
+    explicit Searcher(uint32_t node_budget)
+        : m_budget{node_budget}
+    {
+    }
+
+    ///
+    /// \brief Negamax
+    /// \param own Stones of the side to move
+    /// \param opponent Stones of the side that just moved
+    /// \param depth Plies left
+    /// \param alpha
+    /// \param beta
+    /// \return 1 for a forced win of the side to move, -1 for a forced loss, 0 otherwise
+    ///
+    int Negamax(CellMask own, CellMask opponent, uint8_t depth, int alpha, int beta)
+    {
+        if (HasLine(opponent)) {
+            return -1;
+        }
+        CellMask empty = static_cast<CellMask>(~(own | opponent) & all_cells);
+        if (empty == 0 || depth == 0) {
+            return 0;
+        }
+        if (m_nodes >= m_budget) {
+            m_complete = false;
+            return 0;
+        }
+        ++m_nodes;
+
+        int best = -1;
+        for (; empty != 0; empty &= static_cast<CellMask>(empty - 1)) {
+            auto move = static_cast<CellMask>(empty & -empty);
+            int value = -Negamax(opponent, own | move, depth - 1, -beta, -alpha);
+            if (value > best) {
+                best = value;
+                if (value > alpha) {
+                    alpha = value;
+                    if (alpha >= beta) {
+                        break;
+                    }
+                }
+            }
+        }
+        return best;
+    }
+
+    uint32_t Nodes() const { return m_nodes; }
+
+    /// False once the budget cut a node
+    bool Complete() const { return m_complete; }
+
+private:
+    uint32_t m_budget;
+    uint32_t m_nodes{0};
+    bool m_complete{true};
+};
+
+} // namespace
+
+bool HasLine(CellMask stones)
+{
+    for (auto line : lines) {
+        if ((stones & line) == line) {
+            return true;
+        }
+    }
+    return false;
+}
+
+SearchResult Search(CellMask own, CellMask opponent, uint8_t depth, uint32_t node_budget)
+{
+    TICTACTOE_TRACE_SCOPE("Search");
+    SearchResult result;
+    auto cache = EvaluationCache::Installed();
+    if (cache && cache->Find(own, opponent, depth, result)) {
+        return result;
+    }
+    Searcher searcher{node_budget};
+
+    // Each move gets a full window: the caller needs the value of every move, not the best
+    auto empty = static_cast<CellMask>(~(own | opponent) & all_cells);
+    for (; empty != 0; empty &= static_cast<CellMask>(empty - 1)) {
+        auto move = static_cast<CellMask>(empty & -empty);
+        int value = depth > 0 ? -searcher.Negamax(opponent, own | move, depth - 1, -1, 1) : 0;
+        if (value > 0) {
+            result.wins |= move;
+        }
+        if (value >= 0) {
+            result.safe |= move;
+        }
+    }
+    result.nodes = searcher.Nodes();
+    result.complete = searcher.Complete();
+    if (cache && result.complete) {
+        cache->Store(own, opponent, depth, result);
+    }
+    return result;
+}
+
+} // namespace tictactoe
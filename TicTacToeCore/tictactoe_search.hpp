@@ -0,0 +1,55 @@
+/// @file
+///
+/// @author
+///
+/// @copyright
+
+#ifndef TICTACTOE_SEARCH_HPP
+#define TICTACTOE_SEARCH_HPP
+
+#include <cstdint>
+#include "tictactoecore_global.hpp"
+#include <tictactoe_game.hpp>
+
+namespace tictactoe {
+
+///
+/// \brief The SearchResult struct, the moves proven within the search horizon
+///
+struct SearchResult {
+    /// Moves forcing a win
+    CellMask wins{0};
+    /// Moves not losing by force (wins, draws and unproven moves)
+    CellMask safe{0};
+    /// Nodes visited
+    uint32_t nodes{0};
+    /// False if the node budget cut the search
+    bool complete{true};
+};
+
+///
+/// \brief Search Classify the moves of a position with an alpha-beta search
+///
+/// A win/loss/unknown negamax over bitboards, limited to depth plies (the move itself
+/// included) and node_budget nodes. Moves that could not be proven once the depth or the
+/// budget runs out count as safe, so a shallow search only spots the short tactics. The
+/// installed EvaluationCache, if any, is consulted first.
+/// \param own Stones of the side to move
+/// \param opponent
+/// \param depth
+/// \param node_budget
+/// \return
+///
+TICTACTOECORESHARED_EXPORT SearchResult Search(CellMask own, CellMask opponent, uint8_t depth,
+                                               uint32_t node_budget);
+
+///
+/// \brief HasLine
+/// \param stones
+/// \return True if the stones complete a line
+///
+TICTACTOECORESHARED_EXPORT bool HasLine(CellMask stones);
+
+} // namespace tictactoe
+
+#endif // TICTACTOE_SEARCH_HPP
@@ -0,0 +1,341 @@
+/// @file
+///
+/// @author
+///
+/// @copyright
+
+#ifndef TICTACTOE_SESSION_HPP
+#define TICTACTOE_SESSION_HPP
+
+#if !defined(__cpp_impl_coroutine) && !defined(__cpp_coroutines)
+#error "tictactoe_session.hpp requires C++20 coroutines"
+#endif
+
+#include <coroutine>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <optional>
+#include <utility>
+#include <tictactoe_game.hpp>
+
+namespace tictactoe {
+
+///
+/// \brief The Executor class, where suspended games are resumed
+///
+class Executor {
+public:
+    virtual ~Executor() = default;
+
+    ///
+    /// \brief Post Queue a coroutine to be resumed
+    /// \param handle
+    ///
+    virtual void Post(std::coroutine_handle<> handle) = 0;
+};
+
+///
+/// \brief The QueueExecutor class, a FIFO drained by the caller (e.g. the server loop)
+///
+class QueueExecutor final : public Executor {
+public:
+    void Post(std::coroutine_handle<> handle) override
+    {
+        std::lock_guard<std::mutex> lock{m_mutex};
+        m_queue.push_back(handle);
+    }
+
+    ///
+    /// \brief RunOne Resume the oldest queued coroutine
+    /// \return False if the queue was empty
+    ///
+    bool RunOne()
+    {
+        std::coroutine_handle<> handle;
+        {
+            std::lock_guard<std::mutex> lock{m_mutex};
+            if (m_queue.empty()) {
+                return false;
+            }
+            handle = m_queue.front();
+            m_queue.pop_front();
+        }
+        handle.resume();
+        return true;
+    }
+
+    ///
+    /// \brief Run Resume coroutines until the queue is empty
+    /// \return Number of coroutines resumed
+    ///
+    size_t Run()
+    {
+        size_t count = 0;
+        while (RunOne()) {
+            ++count;
+        }
+        return count;
+    }
+
+private:
+    std::mutex m_mutex;
+    std::deque<std::coroutine_handle<>> m_queue;
+};
+
+///
+/// \brief The Task class, a lazily started coroutine returning a T
+///
+/// Awaiting a task starts it and resumes the awaiter when it completes. A top level task is
+/// started with Start() and owned by the caller until Done().
+///
+template <typename T>
+class Task {
+public:
+    struct promise_type {
+        std::optional<T> value;
+        std::exception_ptr exception;
+        std::coroutine_handle<> continuation;
+
+        Task get_return_object()
+        {
+            return Task{std::coroutine_handle<promise_type>::from_promise(*this)};
+        }
+
+        std::suspend_always initial_suspend() noexcept { return {}; }
+
+        auto final_suspend() noexcept
+        {
+            struct FinalAwaiter {
+                bool await_ready() noexcept { return false; }
+
+                std::coroutine_handle<> await_suspend(
+                    std::coroutine_handle<promise_type> handle) noexcept
+                {
+                    auto continuation = handle.promise().continuation;
+                    return continuation ? continuation : std::noop_coroutine();
+                }
+
+                void await_resume() noexcept {}
+            };
+            return FinalAwaiter{};
+        }
+
+        void return_value(T result) { value = std::move(result); }
+
+        void unhandled_exception() { exception = std::current_exception(); }
+    };
+
+    Task(Task const&) = delete;
+    Task& operator=(Task const&) = delete;
+
+    Task(Task&& other) noexcept
+        : m_handle{std::exchange(other.m_handle, {})}
+    {
+    }
+
+    Task& operator=(Task&& other) noexcept
+    {
+        if (this != &other) {
+            Destroy();
+            m_handle = std::exchange(other.m_handle, {});
+        }
+        return *this;
+    }
+
+    ~Task() { Destroy(); }
+
+    ///
+    /// \brief Start Run a top level task until its first suspension
+    ///
+    void Start() { m_handle.resume(); }
+
+    /// True once the coroutine returned
+    bool Done() const { return m_handle && m_handle.done(); }
+
+    ///
+    /// \brief Result The returned value, rethrows if the coroutine threw
+    /// \return
+    ///
+    T& Result()
+    {
+        if (m_handle.promise().exception) {
+            std::rethrow_exception(m_handle.promise().exception);
+        }
+        return *m_handle.promise().value;
+    }
+
+    bool await_ready() const noexcept { return false; }
+
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiter) noexcept
+    {
+        m_handle.promise().continuation = awaiter;
+        return m_handle;
+    }
+
+    T await_resume() { return std::move(Result()); }
+
+private:
+    explicit Task(std::coroutine_handle<promise_type> handle)
+        : m_handle{handle}
+    {
+    }
+
+    void Destroy()
+    {
+        if (m_handle) {
+            m_handle.destroy();
+            m_handle = {};
+        }
+    }
+
+private:
+    std::coroutine_handle<promise_type> m_handle;
+};
+
+///
+/// \brief The Session class, one game driven by a coroutine
+///
+/// The server submits the human moves with SubmitMove(); the game coroutine (see PlayGame)
+/// waits for them with NextHumanMove() and runs the engine on the executor. A session
+/// waiting for its player only holds the game and the coroutine frame, no thread. A session
+/// and its coroutine must be used from one thread at a time (e.g. the executor's).
+///
+class Session {
+public:
+    ///
+    /// \brief The Move struct
+    ///
+    struct Move {
+        uint8_t x;
+        uint8_t y;
+    };
+
+    ///
+    /// \brief Session constructor
+    /// \param executor Where the game coroutine is resumed
+    /// \param human_side
+    /// \param first_player
+    /// \param difficulty
+    ///
+    Session(Executor& executor, PlayerSide human_side, PlayerType first_player,
+            const Difficulty& difficulty)
+        : m_executor{executor}
+        , m_human_side{human_side}
+        , m_first_player{first_player}
+        , m_difficulty{difficulty}
+        , m_callback{[this](const GameUpdate& update) { m_update = update; }}
+    {
+        m_game.SetCoalesceUpdates(true);
+        m_game.SetCallback(m_callback);
+    }
+
+    Session(Session const&) = delete;
+    Session& operator=(Session const&) = delete;
+
+    ///
+    /// \brief Start Start the game (the computer moves if it goes first)
+    ///
+    void Start() { m_game.Restart(m_human_side, m_first_player, m_difficulty); }
+
+    ///
+    /// \brief SubmitMove Hand a human move to the coroutine waiting for it
+    /// \param x
+    /// \param y
+    /// \return False if no move is awaited or the cell is taken
+    ///
+    bool SubmitMove(uint8_t x, uint8_t y)
+    {
+        if (!m_waiting || x >= board_size || y >= board_size ||
+            m_game.GetCell(x, y).value != CellValue::None) {
+            return false;
+        }
+        m_move = Move{x, y};
+        m_executor.Post(std::exchange(m_waiting, {}));
+        return true;
+    }
+
+    /// True while the coroutine waits for SubmitMove()
+    bool AwaitingMove() const { return static_cast<bool>(m_waiting); }
+
+    ///
+    /// \brief NextHumanMove Awaitable suspending the game until SubmitMove()
+    /// \return
+    ///
+    auto NextHumanMove()
+    {
+        struct MoveAwaiter {
+            Session& session;
+
+            bool await_ready() const noexcept { return false; }
+
+            void await_suspend(std::coroutine_handle<> handle) noexcept
+            {
+                session.m_waiting = handle;
+            }
+
+            Move await_resume() const noexcept { return session.m_move; }
+        };
+        return MoveAwaiter{*this};
+    }
+
+    ///
+    /// \brief Schedule Awaitable continuing the coroutine on the executor
+    /// \return
+    ///
+    auto Schedule()
+    {
+        struct ScheduleAwaiter {
+            Executor& executor;
+
+            bool await_ready() const noexcept { return false; }
+
+            void await_suspend(std::coroutine_handle<> handle) { executor.Post(handle); }
+
+            void await_resume() const noexcept {}
+        };
+        return ScheduleAwaiter{m_executor};
+    }
+
+    /// Game played by the session
+    TicTacToeGame& Game() { return m_game; }
+    const TicTacToeGame& Game() const { return m_game; }
+
+    /// Last update received from the game
+    const GameUpdate& LastUpdate() const { return m_update; }
+
+    /// Current game status
+    GameStatus Status() const { return m_update.status; }
+
+private:
+    Executor& m_executor;
+    PlayerSide m_human_side;
+    PlayerType m_first_player;
+    Difficulty m_difficulty;
+    GameUpdate m_update;
+    GameUpdateCalback m_callback;
+    TicTacToeGame m_game;
+    std::coroutine_handle<> m_waiting;
+    Move m_move{0, 0};
+};
+
+///
+/// \brief PlayGame Play a whole session, awaiting each human move
+/// \param session
+/// \return The final game status
+///
+inline Task<GameStatus> PlayGame(Session& session)
+{
+    co_await session.Schedule();
+    session.Start();
+    while (session.Status() == GameStatus::in_progress) {
+        // SubmitMove() resumes us as an executor job, where the engine reply runs
+        auto move = co_await session.NextHumanMove();
+        session.Game().HumanMove(move.x, move.y);
+    }
+    co_return session.Status();
+}
+
+} // namespace tictactoe
+
+#endif // TICTACTOE_SESSION_HPP
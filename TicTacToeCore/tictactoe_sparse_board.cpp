@@ -0,0 +1,171 @@
+#include "tictactoe_sparse_board.hpp"
+#include <algorithm>
+#include <cassert>
+
+namespace tictactoe {
+
+SparseTicTacToeBoard::SparseTicTacToeBoard(uint8_t win_length,
+                                           std::pmr::memory_resource* resource)
+    : m_cells{resource}
+    , m_candidates{resource}
+    , m_win_length{win_length}
+    , m_stones{0u}
+    , m_longest_x{0u}
+    , m_longest_o{0u}
+    , m_min_x{0}
+    , m_min_y{0}
+    , m_max_x{0}
+    , m_max_y{0}
+{
+    assert(win_length > 0);
+}
+
+SparseCell& SparseTicTacToeBoard::At(int32_t x, int32_t y)
+{
+    auto it = m_cells.find(MakeKey(x, y));
+    if (it == m_cells.end()) {
+        SparseCell cell;
+        cell.x = x;
+        cell.y = y;
+        it = m_cells.emplace(MakeKey(x, y), cell).first;
+    }
+    return it->second;
+}
+
+SparseCell SparseTicTacToeBoard::At(int32_t x, int32_t y) const
+{
+    auto it = m_cells.find(MakeKey(x, y));
+    if (it != m_cells.end()) {
+        return it->second;
+    }
+    SparseCell cell;
+    cell.x = x;
+    cell.y = y;
+    return cell;
+}
+
+bool SparseTicTacToeBoard::Place(int32_t x, int32_t y, CellValue value)
+{
+    assert(value != CellValue::None);
+
+    auto& cell = At(x, y);
+    assert(cell.value == CellValue::None);
+    cell.value = value;
+    cell.attack_points = 0;
+    cell.defense_points = 0;
+
+    // Grow the bounding box
+    if (m_stones == 0) {
+        m_min_x = m_max_x = x;
+        m_min_y = m_max_y = y;
+    }
+    else {
+        m_min_x = std::min(m_min_x, x);
+        m_min_y = std::min(m_min_y, y);
+        m_max_x = std::max(m_max_x, x);
+        m_max_y = std::max(m_max_y, y);
+    }
+    ++m_stones;
+
+    // The cell is no longer a candidate, but its empty neighbours are
+    m_candidates.erase(MakeKey(x, y));
+    for (int32_t dy = -1; dy <= 1; ++dy) {
+        for (int32_t dx = -1; dx <= 1; ++dx) {
+            if ((dx != 0 || dy != 0) && ValueAt(x + dx, y + dy) == CellValue::None) {
+                m_candidates.insert(MakeKey(x + dx, y + dy));
+            }
+        }
+    }
+
+    // Only the four lines through the new stone can have changed
+    uint16_t run = std::max({RunLength(x, y, 1, 0, value), RunLength(x, y, 0, 1, value),
+                             RunLength(x, y, 1, 1, value), RunLength(x, y, 1, -1, value)});
+    auto& longest = (value == CellValue::X) ? m_longest_x : m_longest_o;
+    longest = std::max(longest, run);
+
+    return run >= m_win_length;
+}
+
+SparseCell& SparseTicTacToeBoard::MaxScoreCell()
+{
+    // Nothing played yet, start from the origin
+    if (m_candidates.empty()) {
+        return At(0, 0);
+    }
+
+    SparseCell* best = nullptr;
+    for (auto key : m_candidates) {
+        auto& cell = At(static_cast<int32_t>(key >> 32), static_cast<int32_t>(key));
+        if (best == nullptr) {
+            best = &cell;
+            continue;
+        }
+        int score = cell.attack_points + cell.defense_points;
+        int best_score = best->attack_points + best->defense_points;
+        // Ties go to the first cell in row-major order, as on the fixed board
+        if (score > best_score ||
+            (score == best_score && (cell.y < best->y || (cell.y == best->y && cell.x < best->x)))) {
+            best = &cell;
+        }
+    }
+    return *best;
+}
+
+uint16_t SparseTicTacToeBoard::CountX(int32_t x, int32_t y, CellValue val) const
+{
+    return CountInWindow(x, y, 0, 1, val);
+}
+
+uint16_t SparseTicTacToeBoard::CountY(int32_t x, int32_t y, CellValue val) const
+{
+    return CountInWindow(x, y, 1, 0, val);
+}
+
+uint16_t SparseTicTacToeBoard::CountD1(int32_t x, int32_t y, CellValue val) const
+{
+    return CountInWindow(x, y, 1, 1, val);
+}
+
+uint16_t SparseTicTacToeBoard::CountD2(int32_t x, int32_t y, CellValue val) const
+{
+    return CountInWindow(x, y, 1, -1, val);
+}
+
+uint16_t SparseTicTacToeBoard::LongestRun(CellValue val) const
+{
+    return (val == CellValue::X) ? m_longest_x : (val == CellValue::O) ? m_longest_o : 0;
+}
+
+uint16_t SparseTicTacToeBoard::CountInWindow(int32_t x, int32_t y, int32_t dx, int32_t dy,
+                                             CellValue val) const
+{
+    const int32_t reach = m_win_length - 1;
+    uint16_t sum = 0;
+    for (int32_t i = -reach; i <= reach; ++i) {
+        if (ValueAt(x + i * dx, y + i * dy) == val) {
+            ++sum;
+        }
+    }
+    return sum;
+}
+
+uint16_t SparseTicTacToeBoard::RunLength(int32_t x, int32_t y, int32_t dx, int32_t dy,
+                                         CellValue val) const
+{
+    uint16_t run = 1;
+    for (int32_t i = 1; i < m_win_length && ValueAt(x + i * dx, y + i * dy) == val; ++i) {
+        ++run;
+    }
+    for (int32_t i = 1; i < m_win_length && ValueAt(x - i * dx, y - i * dy) == val; ++i) {
+        ++run;
+    }
+    return run;
+}
+
+CellValue SparseTicTacToeBoard::ValueAt(int32_t x, int32_t y) const
+{
+    auto it = m_cells.find(MakeKey(x, y));
+    return (it != m_cells.end()) ? it->second.value : CellValue::None;
+}
+
+} // namespace tictactoe
@@ -0,0 +1,268 @@
+#ifndef TICTACTOE_SPARSE_BOARD_HPP
+#define TICTACTOE_SPARSE_BOARD_HPP
+
+#include <cstdint>
+#include <memory_resource>
+#include <unordered_map>
+#include <unordered_set>
+#include "tictactoecore_global.hpp"
+#include <tictactoe_board.hpp>
+
+namespace tictactoe {
+
+///
+/// \brief The SparseCell struct, same as Cell but with unbounded coordinates
+///
+struct SparseCell {
+    /// The attack score for the position.
+    uint8_t attack_points{0};
+    /// The defense score for the position
+    uint8_t defense_points{0};
+    /// Cell state (X, O, none)
+    CellValue value{CellValue::None};
+    /// Column
+    int32_t x{0};
+    /// Row
+    int32_t y{0};
+};
+
+///
+/// \brief The SparseTicTacToeBoard class
+///
+/// Unbounded k-in-a-row board. Only the touched cells are stored (keyed by coordinate), so
+/// memory and move generation scale with the number of stones rather than the board area.
+/// Since a row or column has no end, the line iterators and counters work on the window of
+/// win_length - 1 cells on each side of a reference position, which is all a win check needs.
+/// The cell storage is the only allocation source, and it goes through the given memory
+/// resource (e.g. a per-session arena).
+///
+/// This is a separate component, not a drop-in for TicTacToeBoard: TicTacToeGame, the batch
+/// engine, the search and the position keys rely on the fixed board_size x board_size layout
+/// (16 bit cell masks, constexpr board images, cell indices in updates), which an unbounded
+/// board cannot provide. It serves k-in-a-row front ends and reference checks such as
+/// TicTacToePerft --verify.
+///
+class TICTACTOECORESHARED_EXPORT SparseTicTacToeBoard final {
+public:
+    ///
+    /// \brief SparseTicTacToeBoard constructor
+    /// \param win_length Number of aligned stones needed to win
+    /// \param resource Memory resource for the cell storage
+    ///
+    explicit SparseTicTacToeBoard(
+        uint8_t win_length = board_size,
+        std::pmr::memory_resource* resource = std::pmr::get_default_resource());
+
+    ///
+    /// \brief At Non-const getter for board position, the cell is created if missing
+    /// \param x
+    /// \param y
+    /// \return
+    ///
+    SparseCell& At(int32_t x, int32_t y);
+
+    ///
+    /// \brief At Const getter for board position, missing cells are reported empty
+    /// \param x
+    /// \param y
+    /// \return
+    ///
+    SparseCell At(int32_t x, int32_t y) const;
+
+    ///
+    /// \brief Place Put a stone on the board and update the line tracking
+    /// \param x
+    /// \param y
+    /// \param value
+    /// \return True if the stone completes a line of win_length
+    ///
+    bool Place(int32_t x, int32_t y, CellValue value);
+
+    ///
+    /// \brief MaxScoreCell Get the candidate with the highest score (attack + defense points)
+    /// \return
+    ///
+    SparseCell& MaxScoreCell();
+
+    ///
+    /// \brief ForEachCandidate Iterate the empty cells adjacent to at least one stone
+    /// \param pred
+    ///
+    template <typename Pred>
+    void ForEachCandidate(Pred&& pred)
+    {
+        for (auto key : m_candidates) {
+            pred(At(static_cast<int32_t>(key >> 32), static_cast<int32_t>(key)));
+        }
+    }
+
+    ///
+    /// \brief ForEachX Convenience cell iterator for the column window around x, y
+    /// \param x
+    /// \param y
+    /// \param pred
+    /// \param include_empty
+    ///
+    template <typename Pred>
+    void ForEachX(int32_t x, int32_t y, Pred&& pred, bool include_empty = false)
+    {
+        ForEachInWindow(x, y, 0, 1, pred, include_empty);
+    }
+
+    ///
+    /// \brief ForEachY Convenience cell iterator for the row window around x, y
+    /// \param x
+    /// \param y
+    /// \param pred
+    /// \param include_empty
+    ///
+    template <typename Pred>
+    void ForEachY(int32_t x, int32_t y, Pred&& pred, bool include_empty = false)
+    {
+        ForEachInWindow(x, y, 1, 0, pred, include_empty);
+    }
+
+    ///
+    /// \brief ForEachD1 Convenience cell iterator for the first diagonal window around x, y
+    /// \param x
+    /// \param y
+    /// \param pred
+    /// \param include_empty
+    ///
+    template <typename Pred>
+    void ForEachD1(int32_t x, int32_t y, Pred&& pred, bool include_empty = false)
+    {
+        ForEachInWindow(x, y, 1, 1, pred, include_empty);
+    }
+
+    ///
+    /// \brief ForEachD2 Convenience cell iterator for the second diagonal window around x, y
+    /// \param x
+    /// \param y
+    /// \param pred
+    /// \param include_empty
+    ///
+    template <typename Pred>
+    void ForEachD2(int32_t x, int32_t y, Pred&& pred, bool include_empty = false)
+    {
+        ForEachInWindow(x, y, 1, -1, pred, include_empty);
+    }
+
+    ///
+    /// \brief CountX Count positions (X or O) in the column window around x, y
+    /// \param x
+    /// \param y
+    /// \param val
+    /// \return
+    ///
+    uint16_t CountX(int32_t x, int32_t y, CellValue val) const;
+
+    ///
+    /// \brief CountY Count positions (X or O) in the row window around x, y
+    /// \param x
+    /// \param y
+    /// \param val
+    /// \return
+    ///
+    uint16_t CountY(int32_t x, int32_t y, CellValue val) const;
+
+    ///
+    /// \brief CountD1 Count positions (X or O) in the first diagonal window around x, y
+    /// \param x
+    /// \param y
+    /// \param val
+    /// \return
+    ///
+    uint16_t CountD1(int32_t x, int32_t y, CellValue val) const;
+
+    ///
+    /// \brief CountD2 Count positions (X or O) in the second diagonal window around x, y
+    /// \param x
+    /// \param y
+    /// \param val
+    /// \return
+    ///
+    uint16_t CountD2(int32_t x, int32_t y, CellValue val) const;
+
+    ///
+    /// \brief LongestRun Longest line of aligned stones placed so far for a side
+    /// \param val
+    /// \return
+    ///
+    uint16_t LongestRun(CellValue val) const;
+
+    /// Number of stones on the board
+    size_t StoneCount() const { return m_stones; }
+
+    /// Number of aligned stones needed to win
+    uint8_t WinLength() const { return m_win_length; }
+
+    /// Bounding box of the stones (only meaningful when StoneCount() > 0)
+    int32_t MinX() const { return m_min_x; }
+    int32_t MinY() const { return m_min_y; }
+    int32_t MaxX() const { return m_max_x; }
+    int32_t MaxY() const { return m_max_y; }
+
+private:
+    using Key = uint64_t;
+
+    static Key MakeKey(int32_t x, int32_t y)
+    {
+        return (static_cast<Key>(static_cast<uint32_t>(x)) << 32) | static_cast<uint32_t>(y);
+    }
+
+    ///
+    /// \brief ForEachInWindow Walk the window of a line going through x, y with step dx, dy
+    ///
+    template <typename Pred>
+    void ForEachInWindow(int32_t x, int32_t y, int32_t dx, int32_t dy, Pred& pred,
+                         bool include_empty)
+    {
+        const int32_t reach = m_win_length - 1;
+        for (int32_t i = -reach; i <= reach; ++i) {
+            auto cx = x + i * dx;
+            auto cy = y + i * dy;
+            auto value = ValueAt(cx, cy);
+            // Only cells that matter for scoring get materialized: stones and candidates
+            if (value == CellValue::None && m_candidates.count(MakeKey(cx, cy)) == 0) {
+                continue;
+            }
+            if (include_empty || value == CellValue::None) {
+                pred(At(cx, cy));
+            }
+        }
+    }
+
+    ///
+    /// \brief CountInWindow Count the stones of a line window going through x, y
+    ///
+    uint16_t CountInWindow(int32_t x, int32_t y, int32_t dx, int32_t dy, CellValue val) const;
+
+    ///
+    /// \brief RunLength Number of contiguous stones of the same value through x, y
+    ///
+    uint16_t RunLength(int32_t x, int32_t y, int32_t dx, int32_t dy, CellValue val) const;
+
+    ///
+    /// \brief ValueAt Cell value without creating the cell
+    ///
+    CellValue ValueAt(int32_t x, int32_t y) const;
+
+private:
+    /// Stored cells (stones and scored candidates)
+    std::pmr::unordered_map<Key, SparseCell> m_cells;
+    /// Empty cells next to a stone
+    std::pmr::unordered_set<Key> m_candidates;
+    uint8_t m_win_length;
+    size_t m_stones;
+    uint16_t m_longest_x;
+    uint16_t m_longest_o;
+    int32_t m_min_x;
+    int32_t m_min_y;
+    int32_t m_max_x;
+    int32_t m_max_y;
+};
+
+} // namespace tictactoe
+
+#endif // TICTACTOE_SPARSE_BOARD_HPP
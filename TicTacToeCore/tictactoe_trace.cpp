@@ -0,0 +1,161 @@
+/// @file
+///
+/// @author
+///
+/// @copyright
+
+#include "tictactoe_trace.hpp"
+#include <algorithm>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <vector>
+
+namespace tictactoe {
+
+namespace {
+
+///
+/// \brief The Registry struct, owns the buffers so they outlive their threads
+///
+struct Registry {
+    std::mutex mutex;
+    std::vector<std::unique_ptr<TraceBuffer>> buffers;
+    /// Reference points to convert the ticks to microseconds
+    uint64_t origin_ticks{Tracer::Now()};
+    std::chrono::steady_clock::time_point origin_time{std::chrono::steady_clock::now()};
+};
+
+Registry& GetRegistry()
+{
+    static Registry registry;
+    return registry;
+}
+
+TraceBuffer& LocalBuffer()
+{
+    // The buffer of the thread in this module; the header pointer caches it per module
+    thread_local TraceBuffer* buffer = [] {
+        auto& registry = GetRegistry();
+        std::lock_guard<std::mutex> lock{registry.mutex};
+        auto id = static_cast<uint32_t>(registry.buffers.size() + 1);
+        registry.buffers.push_back(std::make_unique<TraceBuffer>(id));
+        return registry.buffers.back().get();
+    }();
+    return *buffer;
+}
+
+double TicksPerMicrosecond(const Registry& registry)
+{
+#ifdef TICTACTOE_TRACE_HAS_RDTSC
+    auto ticks = Tracer::Now() - registry.origin_ticks;
+    auto elapsed = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() -
+                                                             registry.origin_time)
+                       .count();
+    return (ticks > 0 && elapsed > 0) ? ticks / elapsed : 1.0;
+#else
+    // The ticks are steady clock periods
+    return 1.0 / std::chrono::duration<double, std::micro>(
+                     std::chrono::steady_clock::duration{1})
+                     .count();
+#endif
+}
+
+void WriteJsonString(std::ostream& out, const char* text)
+{
+    out << '"';
+    for (; *text != '\0'; ++text) {
+        if (*text == '"' || *text == '\\') {
+            out << '\\';
+        }
+        out << *text;
+    }
+    out << '"';
+}
+
+} // namespace
+
+std::atomic<bool> Tracer::s_enabled{false};
+
+void Tracer::Enable(bool enable)
+{
+    if (enable) {
+        RegisterThread();
+    }
+    s_enabled.store(enable, std::memory_order_relaxed);
+}
+
+TraceBuffer* Tracer::RegisterThread()
+{
+    t_trace_buffer = &LocalBuffer();
+    return t_trace_buffer;
+}
+
+void Tracer::WriteChromeTrace(std::ostream& out)
+{
+    struct Span {
+        const char* name;
+        uint64_t begin;
+        uint64_t end;
+    };
+
+    auto& registry = GetRegistry();
+    std::lock_guard<std::mutex> lock{registry.mutex};
+    auto ticks_per_us = TicksPerMicrosecond(registry);
+
+    auto flags = out.flags();
+    auto precision = out.precision(3);
+    out << std::fixed << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+    bool first_event = true;
+    std::vector<Span> spans;
+    for (const auto& buffer : registry.buffers) {
+        // Seqlock style read: copy the newest spans, then drop those the thread may have
+        // overwritten in the meantime. While head is h, the thread may be writing span h into
+        // the slot of span h - N, so that span counts as lost too.
+        auto head = buffer->head.load(std::memory_order_acquire);
+        auto first = std::max(buffer->first.load(std::memory_order_relaxed),
+                              head + 1 > events_per_thread ? head + 1 - events_per_thread : 0);
+        spans.clear();
+        for (auto i = first; i < head; ++i) {
+            const auto& event = buffer->events[i & (events_per_thread - 1)];
+            spans.push_back({event.name.load(std::memory_order_relaxed),
+                             event.begin.load(std::memory_order_relaxed),
+                             event.end.load(std::memory_order_relaxed)});
+        }
+        std::atomic_thread_fence(std::memory_order_acquire);
+        auto new_head = buffer->head.load(std::memory_order_relaxed);
+        // Spans before this one were, or are being, overwritten (the slot being written
+        // excluded)
+        auto overwritten =
+            new_head + 1 > events_per_thread ? new_head + 1 - events_per_thread : 0;
+        auto skip = overwritten > first ? std::min<uint64_t>(overwritten - first, spans.size())
+                                        : 0;
+
+        for (auto it = spans.begin() + static_cast<std::ptrdiff_t>(skip); it != spans.end();
+             ++it) {
+            out << (first_event ? "\n" : ",\n") << "{\"name\":";
+            WriteJsonString(out, it->name);
+            out << ",\"cat\":\"tictactoe\",\"ph\":\"X\",\"pid\":1,\"tid\":" << buffer->thread_id
+                << ",\"ts\":"
+                << static_cast<int64_t>(it->begin - registry.origin_ticks) / ticks_per_us
+                << ",\"dur\":" << static_cast<double>(it->end - it->begin) / ticks_per_us
+                << "}";
+            first_event = false;
+        }
+    }
+    out << "\n]}\n";
+    out.flags(flags);
+    out.precision(precision);
+}
+
+void Tracer::Clear()
+{
+    auto& registry = GetRegistry();
+    std::lock_guard<std::mutex> lock{registry.mutex};
+    for (const auto& buffer : registry.buffers) {
+        buffer->first.store(buffer->head.load(std::memory_order_acquire),
+                            std::memory_order_relaxed);
+    }
+}
+
+} // namespace tictactoe
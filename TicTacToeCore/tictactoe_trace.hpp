@@ -0,0 +1,191 @@
+/// @file
+///
+/// @author
+///
+/// @copyright
+
+#ifndef TICTACTOE_TRACE_HPP
+#define TICTACTOE_TRACE_HPP
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iosfwd>
+#include "tictactoecore_global.hpp"
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define TICTACTOE_TRACE_HAS_RDTSC
+#include <x86intrin.h>
+#endif
+
+///
+/// \brief TICTACTOE_TRACE_SCOPE Record a span named name (a string literal) until the end of
+/// the enclosing scope
+///
+/// Spans are only compiled in when TICTACTOE_ENABLE_TRACING is defined (qmake CONFIG+=tracing)
+/// and only recorded while Tracer::Enable(true) is in effect.
+///
+#ifdef TICTACTOE_ENABLE_TRACING
+#define TICTACTOE_TRACE_CONCAT_(a, b) a##b
+#define TICTACTOE_TRACE_CONCAT(a, b) TICTACTOE_TRACE_CONCAT_(a, b)
+#define TICTACTOE_TRACE_SCOPE(name)                                                          \
+    ::tictactoe::TraceScope TICTACTOE_TRACE_CONCAT(trace_scope_, __LINE__) { name }
+#else
+#define TICTACTOE_TRACE_SCOPE(name) static_cast<void>(0)
+#endif
+
+namespace tictactoe {
+
+struct TraceBuffer;
+
+///
+/// \brief The Tracer class, collects the spans into per-thread ring buffers
+///
+/// Each thread writes its own buffer without locking; only its first span takes a lock to
+/// register the buffer. A buffer keeps the last events_per_thread spans of its thread.
+/// WriteChromeTrace() can be called at any time from any thread, spans overwritten while it
+/// runs are skipped.
+///
+class TICTACTOECORESHARED_EXPORT Tracer final {
+public:
+    /// Capacity of each thread ring buffer
+    static constexpr size_t events_per_thread = size_t{1} << 15;
+
+    ///
+    /// \brief Enable Start or stop recording
+    ///
+    /// Enabling also registers the buffer of the calling thread, so its spans don't allocate.
+    /// \param enable
+    ///
+    static void Enable(bool enable);
+
+    /// True while recording
+    static bool Enabled() { return s_enabled.load(std::memory_order_relaxed); }
+
+    ///
+    /// \brief Now Timestamp in ticks: TSC cycles where available, steady clock ns otherwise
+    /// \return
+    ///
+    static uint64_t Now()
+    {
+#ifdef TICTACTOE_TRACE_HAS_RDTSC
+        return __rdtsc();
+#else
+        return static_cast<uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count());
+#endif
+    }
+
+    ///
+    /// \brief Record Append a span to the buffer of the calling thread
+    /// \param name Must outlive the tracer (a string literal)
+    /// \param begin Ticks
+    /// \param end Ticks
+    ///
+    static inline void Record(const char* name, uint64_t begin, uint64_t end);
+
+    ///
+    /// \brief RegisterThread Create the buffer of the calling thread, once per thread
+    /// \return
+    ///
+    static TraceBuffer* RegisterThread();
+
+    ///
+    /// \brief WriteChromeTrace Export the recorded spans as Chrome trace event JSON
+    ///
+    /// The output loads in chrome://tracing and in the Perfetto UI.
+    /// \param out
+    ///
+    static void WriteChromeTrace(std::ostream& out);
+
+    ///
+    /// \brief Clear Drop the recorded spans of all the threads
+    ///
+    static void Clear();
+
+private:
+    static std::atomic<bool> s_enabled;
+};
+
+///
+/// \brief The TraceEvent struct, one span slot
+///
+/// The fields are atomics so an export can read a slot while its thread overwrites it;
+/// relaxed accesses compile to plain loads and stores.
+///
+struct TraceEvent {
+    std::atomic<const char*> name{nullptr};
+    std::atomic<uint64_t> begin{0};
+    std::atomic<uint64_t> end{0};
+};
+
+///
+/// \brief The TraceBuffer struct, single writer ring buffer of a thread
+///
+/// Defined here so Record() is inlined into the spans; only the tracer touches it.
+///
+struct TraceBuffer {
+    explicit TraceBuffer(uint32_t id)
+        : thread_id{id}
+    {
+    }
+
+    uint32_t thread_id;
+    /// Number of spans ever written
+    std::atomic<uint64_t> head{0};
+    /// Spans before this one were cleared
+    std::atomic<uint64_t> first{0};
+    TraceEvent events[Tracer::events_per_thread];
+};
+
+static_assert((Tracer::events_per_thread & (Tracer::events_per_thread - 1)) == 0,
+              "the ring buffer size must be a power of two");
+
+/// Buffer of the calling thread, null until its first span. Constant initialized, so reading
+/// it needs no thread_local initialization guard.
+inline thread_local TraceBuffer* t_trace_buffer = nullptr;
+
+void Tracer::Record(const char* name, uint64_t begin, uint64_t end)
+{
+    auto* buffer = t_trace_buffer;
+    if (buffer == nullptr) {
+        buffer = RegisterThread();
+    }
+    auto head = buffer->head.load(std::memory_order_relaxed);
+    auto& event = buffer->events[head & (events_per_thread - 1)];
+    event.name.store(name, std::memory_order_relaxed);
+    event.begin.store(begin, std::memory_order_relaxed);
+    event.end.store(end, std::memory_order_relaxed);
+    buffer->head.store(head + 1, std::memory_order_release);
+}
+
+///
+/// \brief The TraceScope class, records a span from construction to destruction
+///
+/// Use through TICTACTOE_TRACE_SCOPE. When the tracer is disabled, it costs a relaxed load.
+///
+class TraceScope final {
+public:
+    explicit TraceScope(const char* name)
+        : m_name{name}
+        , m_begin{Tracer::Enabled() ? Tracer::Now() : 0}
+    {
+    }
+
+    ~TraceScope()
+    {
+        if (m_begin != 0) {
+            Tracer::Record(m_name, m_begin, Tracer::Now());
+        }
+    }
+
+    TraceScope(TraceScope const&) = delete;
+    TraceScope& operator=(TraceScope const&) = delete;
+
+private:
+    const char* m_name;
+    uint64_t m_begin;
+};
+
+} // namespace tictactoe
+
+#endif // TICTACTOE_TRACE_HPP
@@ -0,0 +1,29 @@
+#-------------------------------------------------
+#
+# Training data exporter for TicTacToeCore
+#
+#-------------------------------------------------
+
+QT       -= gui
+
+TARGET = TicTacToeExport
+TEMPLATE = app
+CONFIG += c++17
+CONFIG += console thread
+CONFIG -= app_bundle
+
+DEFINES += QT_DEPRECATED_WARNINGS
+
+SOURCES += \
+        main.cpp \
+        npy_writer.cpp
+
+HEADERS += \
+        npy_writer.hpp
+
+win32:CONFIG(release, debug|release): LIBS += -L$$OUT_PWD/../TicTacToeCore/release/ -lTicTacToeCore
+else:win32:CONFIG(debug, debug|release): LIBS += -L$$OUT_PWD/../TicTacToeCore/debug/ -lTicTacToeCore
+else:unix: LIBS += -L$$OUT_PWD/../TicTacToeCore/ -lTicTacToeCore
+
+INCLUDEPATH += $$PWD/../TicTacToeCore
+DEPENDPATH += $$PWD/../TicTacToeCore
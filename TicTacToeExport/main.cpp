@@ -0,0 +1,447 @@
+/// @file
+///
+/// Exports training samples (position, best move, value) for a learned evaluator.
+///
+/// Every position reachable from the empty board is enumerated in parallel, canonicalized
+/// under the 8 board symmetries and deduplicated, solved by negamax, and streamed to NumPy
+/// arrays through a double buffer so the enumeration never waits on the disk:
+///     positions.npy   int8 (N, cells)   +1 side to move, -1 opponent, 0 empty
+///     best_move.npy   int8 (N,)         cell index y * board_size + x
+///     value.npy       int8 (N,)         +1 win, 0 draw, -1 loss for the side to move
+///
+/// The exporter covers the board the core is built for (3x3), like the Evaluator it trains:
+/// positions are keyed by the 16 bit masks of PositionKey and the dedup and solver tables are
+/// in memory. Larger boards would need wider keys, a disk-backed dedup and a solver that
+/// does not search exhaustively.
+///
+/// Usage:
+///     TicTacToeExport <output_dir> [--threads N] [--buffer samples]
+///
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <cstdlib>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include <tictactoe_position.hpp>
+#include "npy_writer.hpp"
+
+namespace {
+
+using namespace tictactoe;
+
+constexpr size_t cell_count = board_size * board_size;
+static_assert(cell_count <= 16, "positions are keyed by 16 bit cell masks");
+
+using Mask = uint32_t;
+
+///
+/// \brief The Position struct, stones of the side to move and of its opponent
+///
+struct Position {
+    Mask own;
+    Mask opponent;
+};
+
+///
+/// \brief The Sample struct
+///
+struct Sample {
+    std::array<int8_t, cell_count> cells;
+    int8_t best_move;
+    int8_t value;
+};
+
+constexpr Mask full_board = (1u << cell_count) - 1;
+
+///
+/// \brief Lines All the winning lines as masks
+///
+std::vector<Mask> Lines()
+{
+    std::vector<Mask> lines;
+    Mask d1 = 0, d2 = 0;
+    for (uint8_t i = 0; i < board_size; ++i) {
+        Mask row = 0, column = 0;
+        for (uint8_t j = 0; j < board_size; ++j) {
+            row |= 1u << (i * board_size + j);
+            column |= 1u << (j * board_size + i);
+        }
+        lines.push_back(row);
+        lines.push_back(column);
+        d1 |= 1u << (i * board_size + i);
+        d2 |= 1u << (i * board_size + board_size - 1 - i);
+    }
+    lines.push_back(d1);
+    lines.push_back(d2);
+    return lines;
+}
+
+const auto lines = Lines();
+
+bool HasLine(Mask stones)
+{
+    return std::any_of(lines.begin(), lines.end(),
+                       [stones](Mask line) { return (stones & line) == line; });
+}
+
+PositionKey Key(const Position& p)
+{
+    return MakeKey(static_cast<CellMask>(p.own), static_cast<CellMask>(p.opponent));
+}
+
+///
+/// \brief The Solver class, memoized negamax for the side to move
+///
+/// The values are memoized per canonical position, as symmetric positions have the same value,
+/// so the table only holds the positions actually reached.
+///
+class Solver {
+public:
+    int8_t Value(const Position& p)
+    {
+        auto key = CanonicalKey(Key(p));
+        auto it = m_memo.find(key);
+        if (it != m_memo.end()) {
+            return it->second;
+        }
+        int8_t best = -1;
+        if (HasLine(p.opponent)) {
+            best = -1;
+        }
+        else if ((p.own | p.opponent) == full_board) {
+            best = 0;
+        }
+        else {
+            for (uint8_t i = 0; i < cell_count && best < 1; ++i) {
+                if (!((p.own | p.opponent) & (1u << i))) {
+                    best = std::max<int8_t>(best, -Value({p.opponent, p.own | (1u << i)}));
+                }
+            }
+        }
+        m_memo.emplace(key, best);
+        return best;
+    }
+
+    ///
+    /// \brief BestMove First move reaching the position value
+    ///
+    int8_t BestMove(const Position& p)
+    {
+        auto value = Value(p);
+        for (uint8_t i = 0; i < cell_count; ++i) {
+            if (!((p.own | p.opponent) & (1u << i)) &&
+                -Value({p.opponent, p.own | (1u << i)}) == value) {
+                return static_cast<int8_t>(i);
+            }
+        }
+        return -1;
+    }
+
+private:
+    std::unordered_map<PositionKey, int8_t> m_memo;
+};
+
+///
+/// \brief The SampleSink class, double buffered writer shared by the enumeration threads
+///
+class SampleSink {
+public:
+    SampleSink(const std::string& dir, size_t capacity)
+        : m_positions{dir + "/positions.npy", cell_count}
+        , m_best_moves{dir + "/best_move.npy", 0}
+        , m_values{dir + "/value.npy", 0}
+        , m_capacity{capacity}
+        , m_done{false}
+        , m_writer{[this] { WriterLoop(); }}
+    {
+        m_front.reserve(m_capacity);
+        m_back.reserve(m_capacity);
+    }
+
+    ~SampleSink() { Finish(); }
+
+    bool IsOpen() const
+    {
+        return m_positions.IsOpen() && m_best_moves.IsOpen() && m_values.IsOpen();
+    }
+
+    ///
+    /// \brief Push Append a batch of samples, swapping buffers when the front one is full
+    ///
+    void Push(const std::vector<Sample>& samples)
+    {
+        std::unique_lock<std::mutex> lock{m_mutex};
+        m_front.insert(m_front.end(), samples.begin(), samples.end());
+        if (m_front.size() >= m_capacity) {
+            // Only waits if the writer is still flushing the previous buffer
+            m_idle.wait(lock, [this] { return m_back.empty(); });
+            std::swap(m_front, m_back);
+            m_ready.notify_one();
+        }
+    }
+
+    ///
+    /// \brief Finish Flush everything and close the files
+    /// \return Number of samples written, or -1 on I/O error
+    ///
+    long long Finish()
+    {
+        if (m_writer.joinable()) {
+            {
+                std::lock_guard<std::mutex> lock{m_mutex};
+                m_done = true;
+            }
+            m_ready.notify_one();
+            m_writer.join();
+            Flush(m_front);
+            bool ok = m_positions.Close() & m_best_moves.Close() & m_values.Close();
+            m_result = ok ? static_cast<long long>(m_written) : -1;
+        }
+        return m_result;
+    }
+
+private:
+    void WriterLoop()
+    {
+        std::unique_lock<std::mutex> lock{m_mutex};
+        for (;;) {
+            m_ready.wait(lock, [this] { return m_done || !m_back.empty(); });
+            if (m_back.empty() && m_done) {
+                return;
+            }
+            // Write without holding the lock so the producers can refill the front buffer
+            lock.unlock();
+            Flush(m_back);
+            lock.lock();
+            m_back.clear();
+            m_idle.notify_all();
+        }
+    }
+
+    void Flush(const std::vector<Sample>& samples)
+    {
+        m_column.resize(samples.size() * cell_count);
+        for (size_t i = 0; i < samples.size(); ++i) {
+            std::copy(samples[i].cells.begin(), samples[i].cells.end(),
+                      m_column.begin() + i * cell_count);
+        }
+        m_positions.Write(m_column.data(), samples.size());
+
+        for (size_t i = 0; i < samples.size(); ++i) {
+            m_column[i] = samples[i].best_move;
+        }
+        m_best_moves.Write(m_column.data(), samples.size());
+
+        for (size_t i = 0; i < samples.size(); ++i) {
+            m_column[i] = samples[i].value;
+        }
+        m_values.Write(m_column.data(), samples.size());
+
+        m_written += samples.size();
+    }
+
+private:
+    NpyWriter m_positions;
+    NpyWriter m_best_moves;
+    NpyWriter m_values;
+    size_t m_capacity;
+    size_t m_written{0};
+    long long m_result{0};
+    std::vector<Sample> m_front;
+    std::vector<Sample> m_back;
+    std::vector<int8_t> m_column;
+    std::mutex m_mutex;
+    std::condition_variable m_ready;
+    std::condition_variable m_idle;
+    bool m_done;
+    std::thread m_writer;
+};
+
+///
+/// \brief The SeenSet class, sharded set of the canonical positions already exported
+///
+class SeenSet {
+public:
+    bool Insert(PositionKey key)
+    {
+        auto& shard = m_shards[key % m_shards.size()];
+        std::lock_guard<std::mutex> lock{shard.mutex};
+        return shard.keys.insert(key).second;
+    }
+
+private:
+    struct Shard {
+        std::mutex mutex;
+        std::unordered_set<PositionKey> keys;
+    };
+    std::array<Shard, 64> m_shards;
+};
+
+///
+/// \brief The Enumerator class, depth first walk of one subtree
+///
+class Enumerator {
+public:
+    Enumerator(SeenSet& seen, SampleSink& sink)
+        : m_seen{seen}
+        , m_sink{sink}
+    {
+        m_batch.reserve(batch_size);
+    }
+
+    ~Enumerator() { FlushBatch(); }
+
+    ///
+    /// \brief Walk Export a position and its subtree
+    ///
+    void Walk(const Position& p)
+    {
+        if (!Visit(p)) {
+            return;
+        }
+        for (uint8_t i = 0; i < cell_count; ++i) {
+            if (!((p.own | p.opponent) & (1u << i))) {
+                Walk({p.opponent, p.own | (1u << i)});
+            }
+        }
+    }
+
+    ///
+    /// \brief Visit Export a single position
+    /// \return False if the position is terminal or a symmetric one was already visited
+    ///
+    bool Visit(const Position& p)
+    {
+        // The previous move won or filled the board
+        if (HasLine(p.opponent) || (p.own | p.opponent) == full_board) {
+            return false;
+        }
+        // A symmetric position was already exported, and so was its subtree
+        auto key = CanonicalKey(Key(p));
+        if (!m_seen.Insert(key)) {
+            return false;
+        }
+        Position canonical{XStones(key), OStones(key)};
+
+        Sample sample;
+        for (uint8_t i = 0; i < cell_count; ++i) {
+            sample.cells[i] = (canonical.own & (1u << i))        ? 1
+                              : (canonical.opponent & (1u << i)) ? -1
+                                                                 : 0;
+        }
+        sample.best_move = m_solver.BestMove(canonical);
+        sample.value = m_solver.Value(canonical);
+        m_batch.push_back(sample);
+        if (m_batch.size() == batch_size) {
+            FlushBatch();
+        }
+        return true;
+    }
+
+private:
+    void FlushBatch()
+    {
+        if (!m_batch.empty()) {
+            m_sink.Push(m_batch);
+            m_batch.clear();
+        }
+    }
+
+private:
+    static constexpr size_t batch_size = 4096;
+    SeenSet& m_seen;
+    SampleSink& m_sink;
+    Solver m_solver;
+    std::vector<Sample> m_batch;
+};
+
+///
+/// \brief SplitPoints Positions after the first plies, distributed to the threads
+///
+void SplitPoints(const Position& p, uint8_t depth, std::vector<Position>& points)
+{
+    if (depth == 0 || HasLine(p.opponent)) {
+        points.push_back(p);
+        return;
+    }
+    for (uint8_t i = 0; i < cell_count; ++i) {
+        if (!((p.own | p.opponent) & (1u << i))) {
+            SplitPoints({p.opponent, p.own | (1u << i)}, depth - 1, points);
+        }
+    }
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    if (argc < 2) {
+        std::cerr << "usage: " << argv[0] << " <output_dir> [--threads N] [--buffer samples]\n";
+        return EXIT_FAILURE;
+    }
+
+    std::string dir = argv[1];
+    size_t threads = std::max(1u, std::thread::hardware_concurrency());
+    size_t buffer = 1 << 20;
+    for (int i = 2; i + 1 < argc; i += 2) {
+        std::string option = argv[i];
+        if (option == "--threads") {
+            threads = std::max(1ul, std::strtoul(argv[i + 1], nullptr, 10));
+        }
+        else if (option == "--buffer") {
+            buffer = std::max(1ul, std::strtoul(argv[i + 1], nullptr, 10));
+        }
+    }
+
+    SampleSink sink{dir, buffer};
+    if (!sink.IsOpen()) {
+        std::cerr << "cannot create the output files in " << dir << "\n";
+        return EXIT_FAILURE;
+    }
+    SeenSet seen;
+
+    // The first plies are exported up front, the subtrees below them in parallel
+    constexpr uint8_t split_depth = 2;
+    {
+        Enumerator enumerator{seen, sink};
+        for (uint8_t depth = 0; depth < split_depth; ++depth) {
+            std::vector<Position> shallow;
+            SplitPoints({0, 0}, depth, shallow);
+            for (const auto& p : shallow) {
+                enumerator.Visit(p);
+            }
+        }
+    }
+
+    std::vector<Position> points;
+    SplitPoints({0, 0}, split_depth, points);
+    std::atomic<size_t> next{0};
+    std::vector<std::thread> workers;
+    for (size_t t = 0; t < threads; ++t) {
+        workers.emplace_back([&] {
+            Enumerator enumerator{seen, sink};
+            for (size_t i = next++; i < points.size(); i = next++) {
+                enumerator.Walk(points[i]);
+            }
+        });
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+
+    auto written = sink.Finish();
+    if (written < 0) {
+        std::cerr << "write error in " << dir << "\n";
+        return EXIT_FAILURE;
+    }
+    std::cout << written << " samples written to " << dir << "\n";
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,70 @@
+#include "npy_writer.hpp"
+#include <cstring>
+
+namespace {
+
+/// Header size including the magic string, room for a shape of up to 20 digits per dimension
+constexpr size_t header_size = 128;
+
+} // namespace
+
+NpyWriter::NpyWriter(const std::string& path, size_t columns)
+    : m_file{std::fopen(path.c_str(), "wb")}
+    , m_columns{columns}
+    , m_rows{0}
+    , m_failed{false}
+{
+    if (m_file) {
+        m_failed = !WriteHeader();
+    }
+}
+
+NpyWriter::~NpyWriter()
+{
+    Close();
+}
+
+void NpyWriter::Write(const int8_t* data, size_t rows)
+{
+    size_t count = rows * (m_columns ? m_columns : 1);
+    if (m_file && std::fwrite(data, 1, count, m_file) != count) {
+        m_failed = true;
+    }
+    m_rows += rows;
+}
+
+bool NpyWriter::Close()
+{
+    if (!m_file) {
+        return !m_failed;
+    }
+    if (std::fseek(m_file, 0, SEEK_SET) != 0 || !WriteHeader()) {
+        m_failed = true;
+    }
+    if (std::fclose(m_file) != 0) {
+        m_failed = true;
+    }
+    m_file = nullptr;
+    return !m_failed;
+}
+
+bool NpyWriter::WriteHeader()
+{
+    std::string shape = std::to_string(m_rows) + ",";
+    if (m_columns) {
+        shape += " " + std::to_string(m_columns);
+    }
+
+    // Format 1.0: magic, version, little endian header length, then a python dict literal
+    // padded with spaces and terminated by a newline
+    std::string header = "\x93NUMPY";
+    header += '\x01';
+    header += '\x00';
+    header += static_cast<char>((header_size - 10) & 0xff);
+    header += static_cast<char>((header_size - 10) >> 8);
+    header += "{'descr': '|i1', 'fortran_order': False, 'shape': (" + shape + "), }";
+    header.resize(header_size - 1, ' ');
+    header += '\n';
+
+    return std::fwrite(header.data(), 1, header.size(), m_file) == header.size();
+}
@@ -0,0 +1,61 @@
+/// @file
+///
+/// @author
+///
+/// @copyright
+
+#ifndef NPY_WRITER_HPP
+#define NPY_WRITER_HPP
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+
+///
+/// \brief The NpyWriter class streams an int8 array to a NumPy .npy file
+///
+/// The number of rows is not known up front, so the header is written with a fixed size and
+/// patched with the final shape on Close().
+///
+class NpyWriter final {
+public:
+    ///
+    /// \brief NpyWriter constructor
+    /// \param path
+    /// \param columns Row width, 0 for a one dimensional array
+    ///
+    NpyWriter(const std::string& path, size_t columns);
+
+    NpyWriter(NpyWriter const&) = delete;
+    NpyWriter& operator=(NpyWriter const&) = delete;
+
+    /// Closes the file
+    ~NpyWriter();
+
+    /// True if the file could be opened
+    bool IsOpen() const { return m_file != nullptr; }
+
+    ///
+    /// \brief Write Append whole rows
+    /// \param data
+    /// \param rows
+    ///
+    void Write(const int8_t* data, size_t rows);
+
+    ///
+    /// \brief Close Patch the header with the final shape and close the file
+    /// \return False on I/O error
+    ///
+    bool Close();
+
+private:
+    bool WriteHeader();
+
+private:
+    std::FILE* m_file;
+    size_t m_columns;
+    size_t m_rows;
+    bool m_failed;
+};
+
+#endif // NPY_WRITER_HPP
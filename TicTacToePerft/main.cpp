@@ -0,0 +1,611 @@
+/// @file
+///
+/// Counts every legal move sequence of k-in-a-row on a W x H board, ply by ply, with the
+/// games ending on each ply (X wins, O wins, draws).
+///
+/// The rules are TicTacToeGame's: X moves first, the sides alternate, a game ends when the
+/// last move completes a line of k or fills the board (a line completed by the last cell
+/// wins). The enumeration runs on its own bit boards for speed; --verify replays the tree on
+/// SparseTicTacToeBoard and, on 3x3, through TicTacToeGame itself, which decides when each
+/// game ends. On 3x3 the whole tree holds 255168 games (131184 X wins, 77904 O wins, 46080
+/// draws). The counts double as a move generation and win detection oracle and as a
+/// throughput benchmark.
+///
+/// Usage:
+///     TicTacToePerft [options]
+///         --size WxH      board geometry (default 3x3)
+///         --k N           aligned stones needed to win (default min(W, H))
+///         --depth N       plies (default W * H)
+///         --threads N     split the subtrees over N threads (default: all cores)
+///         --split N       plies expanded before splitting (default 2)
+///         --memo          reuse the counts of symmetric and transposed positions
+///         --verify        check the counts against SparseTicTacToeBoard and, on 3x3,
+///                         TicTacToeGame (slow, one board copy or game replay per node)
+///
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include <tictactoe_game.hpp>
+#include <tictactoe_position.hpp>
+#include <tictactoe_sparse_board.hpp>
+
+namespace {
+
+using namespace tictactoe;
+
+using Mask = uint64_t;
+
+constexpr uint8_t no_cell = 0xff;
+
+/// Index of the lowest set bit, stones must not be 0
+uint8_t LowestCell(Mask stones)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    return static_cast<uint8_t>(__builtin_ctzll(stones));
+#else
+    uint8_t cell = 0;
+    for (; (stones & 1) == 0; stones >>= 1) {
+        ++cell;
+    }
+    return cell;
+#endif
+}
+
+///
+/// \brief The Tally struct, counts for one ply
+///
+struct Tally {
+    /// Move sequences reaching the ply, finished games included
+    uint64_t nodes{0};
+    uint64_t x_wins{0};
+    uint64_t o_wins{0};
+    uint64_t draws{0};
+
+    uint64_t Games() const { return x_wins + o_wins + draws; }
+
+    bool operator==(const Tally& other) const
+    {
+        return nodes == other.nodes && x_wins == other.x_wins && o_wins == other.o_wins &&
+               draws == other.draws;
+    }
+};
+
+///
+/// \brief Counts Tallies indexed by ply
+///
+using Counts = std::vector<Tally>;
+
+void Add(Counts& counts, const Counts& other, size_t offset = 0)
+{
+    for (size_t i = 0; i < other.size(); ++i) {
+        auto& tally = counts[offset + i];
+        tally.nodes += other[i].nodes;
+        tally.x_wins += other[i].x_wins;
+        tally.o_wins += other[i].o_wins;
+        tally.draws += other[i].draws;
+    }
+}
+
+///
+/// \brief The Geometry class, board cells, winning lines and symmetries as bit masks
+///
+class Geometry {
+public:
+    Geometry(uint8_t width, uint8_t height, uint8_t win_length)
+        : m_width{width}
+        , m_height{height}
+        , m_win_length{win_length}
+        , m_lines(width * height)
+    {
+        const int directions[4][2] = {{1, 0}, {0, 1}, {1, 1}, {1, -1}};
+        for (const auto& d : directions) {
+            for (int y = 0; y < height; ++y) {
+                for (int x = 0; x < width; ++x) {
+                    int end_x = x + d[0] * (win_length - 1), end_y = y + d[1] * (win_length - 1);
+                    if (end_x < 0 || end_x >= width || end_y < 0 || end_y >= height) {
+                        continue;
+                    }
+                    Mask line = 0;
+                    for (int i = 0; i < win_length; ++i) {
+                        line |= Bit((x + d[0] * i) + (y + d[1] * i) * width);
+                    }
+                    for (int i = 0; i < win_length; ++i) {
+                        m_lines[(x + d[0] * i) + (y + d[1] * i) * width].push_back(line);
+                    }
+                }
+            }
+        }
+
+        // The 8 symmetries of a square, the 4 of a rectangle
+        for (int s = 0; s < (width == height ? 8 : 4); ++s) {
+            std::vector<uint8_t> permutation(width * height);
+            for (int y = 0; y < height; ++y) {
+                for (int x = 0; x < width; ++x) {
+                    int tx = x, ty = y;
+                    if (width == height) {
+                        for (int r = 0; r < s % 4; ++r) {
+                            int rx = width - 1 - ty;
+                            ty = tx;
+                            tx = rx;
+                        }
+                        if (s >= 4) {
+                            tx = width - 1 - tx;
+                        }
+                    }
+                    else {
+                        tx = (s & 1) ? width - 1 - x : x;
+                        ty = (s & 2) ? height - 1 - y : y;
+                    }
+                    permutation[y * width + x] = static_cast<uint8_t>(ty * width + tx);
+                }
+            }
+            m_symmetries.push_back(permutation);
+        }
+    }
+
+    static Mask Bit(int cell) { return Mask{1} << cell; }
+
+    uint8_t Width() const { return m_width; }
+    uint8_t Height() const { return m_height; }
+    uint8_t WinLength() const { return m_win_length; }
+    uint8_t Cells() const { return static_cast<uint8_t>(m_width * m_height); }
+    Mask Full() const { return Cells() == 64 ? ~Mask{0} : Bit(Cells()) - 1; }
+
+    ///
+    /// \brief Wins Does the stone on cell complete a line?
+    ///
+    bool Wins(Mask stones, uint8_t cell) const
+    {
+        for (auto line : m_lines[cell]) {
+            if ((stones & line) == line) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    ///
+    /// \brief Canonical Smallest image of a position among the board symmetries
+    ///
+    std::pair<Mask, Mask> Canonical(Mask x_stones, Mask o_stones) const
+    {
+        // The table driven core routine handles the 3x3 board
+        if (m_width == board_size && m_height == board_size) {
+            auto key = CanonicalKey(MakeKey(static_cast<CellMask>(x_stones),
+                                            static_cast<CellMask>(o_stones)));
+            return {XStones(key), OStones(key)};
+        }
+        std::pair<Mask, Mask> best{x_stones, o_stones};
+        for (const auto& permutation : m_symmetries) {
+            std::pair<Mask, Mask> image{Transform(x_stones, permutation),
+                                        Transform(o_stones, permutation)};
+            best = std::min(best, image);
+        }
+        return best;
+    }
+
+private:
+    static Mask Transform(Mask stones, const std::vector<uint8_t>& permutation)
+    {
+        Mask image = 0;
+        for (; stones != 0; stones &= stones - 1) {
+            image |= Bit(permutation[LowestCell(stones)]);
+        }
+        return image;
+    }
+
+private:
+    uint8_t m_width;
+    uint8_t m_height;
+    uint8_t m_win_length;
+    /// Winning lines through each cell
+    std::vector<std::vector<Mask>> m_lines;
+    std::vector<std::vector<uint8_t>> m_symmetries;
+};
+
+///
+/// \brief The Perft class, depth first enumeration on bit boards
+///
+/// A Perft instance is used by one thread: the memo table is not shared.
+///
+class Perft {
+public:
+    Perft(const Geometry& geometry, uint8_t depth, bool memo)
+        : m_geometry{geometry}
+        , m_depth{depth}
+        , m_memo_enabled{memo}
+    {
+    }
+
+    ///
+    /// \brief Walk Count a position and its subtree
+    /// \param x_stones
+    /// \param o_stones
+    /// \param last Cell of the last move, no_cell at the root
+    /// \param ply Moves played so far
+    /// \param counts Indexed by absolute ply
+    ///
+    void Walk(Mask x_stones, Mask o_stones, uint8_t last, uint8_t ply, Counts& counts)
+    {
+        auto& tally = counts[ply];
+        ++tally.nodes;
+        if (IsOver(x_stones, o_stones, last, ply, tally) || ply == m_depth) {
+            return;
+        }
+
+        if (!m_memo_enabled) {
+            Expand(x_stones, o_stones, ply, counts);
+            return;
+        }
+
+        // The subtree counts only depend on the position, and are the same for its symmetric
+        // images. The node itself was counted above.
+        auto key = m_geometry.Canonical(x_stones, o_stones);
+        auto it = m_memo.find(key);
+        if (it == m_memo.end()) {
+            Counts subtree(m_depth + 1);
+            Expand(x_stones, o_stones, ply, subtree);
+            it = m_memo.emplace(key, Counts(subtree.begin() + ply + 1, subtree.end())).first;
+        }
+        Add(counts, it->second, ply + 1);
+    }
+
+    ///
+    /// \brief IsOver Count the result if the last move ended the game
+    ///
+    bool IsOver(Mask x_stones, Mask o_stones, uint8_t last, uint8_t ply, Tally& tally) const
+    {
+        if (last == no_cell) {
+            return false;
+        }
+        // X plays the even plies, so X made move number ply if it is odd
+        bool x_moved = ply % 2 == 1;
+        if (m_geometry.Wins(x_moved ? x_stones : o_stones, last)) {
+            ++(x_moved ? tally.x_wins : tally.o_wins);
+            return true;
+        }
+        if ((x_stones | o_stones) == m_geometry.Full()) {
+            ++tally.draws;
+            return true;
+        }
+        return false;
+    }
+
+private:
+    void Expand(Mask x_stones, Mask o_stones, uint8_t ply, Counts& counts)
+    {
+        bool x_moves = ply % 2 == 0;
+        for (Mask empty = ~(x_stones | o_stones) & m_geometry.Full(); empty != 0;
+             empty &= empty - 1) {
+            auto cell = LowestCell(empty);
+            auto bit = Geometry::Bit(cell);
+            if (x_moves) {
+                Walk(x_stones | bit, o_stones, cell, ply + 1, counts);
+            }
+            else {
+                Walk(x_stones, o_stones | bit, cell, ply + 1, counts);
+            }
+        }
+    }
+
+    struct KeyHash {
+        size_t operator()(const std::pair<Mask, Mask>& key) const
+        {
+            return std::hash<Mask>{}(key.first * 0x9e3779b97f4a7c15ull ^ key.second);
+        }
+    };
+
+private:
+    const Geometry& m_geometry;
+    uint8_t m_depth;
+    bool m_memo_enabled;
+    std::unordered_map<std::pair<Mask, Mask>, Counts, KeyHash> m_memo;
+};
+
+///
+/// \brief The SplitPoint struct, a subtree handed to a thread
+///
+struct SplitPoint {
+    Mask x_stones;
+    Mask o_stones;
+    uint8_t last;
+    uint8_t ply;
+};
+
+///
+/// \brief Split Expand the first plies, counting their inner nodes, and collect the subtrees
+///
+void Split(const Perft& perft, const SplitPoint& point, uint8_t split_depth, uint8_t depth,
+           const Geometry& geometry, Counts& counts, std::vector<SplitPoint>& points)
+{
+    Tally probe;
+    if (point.ply == split_depth || point.ply == depth ||
+        perft.IsOver(point.x_stones, point.o_stones, point.last, point.ply, probe)) {
+        points.push_back(point);
+        return;
+    }
+    ++counts[point.ply].nodes;
+    bool x_moves = point.ply % 2 == 0;
+    for (uint8_t cell = 0; cell < geometry.Cells(); ++cell) {
+        auto bit = Geometry::Bit(cell);
+        if ((point.x_stones | point.o_stones) & bit) {
+            continue;
+        }
+        SplitPoint child{x_moves ? point.x_stones | bit : point.x_stones,
+                         x_moves ? point.o_stones : point.o_stones | bit, cell,
+                         static_cast<uint8_t>(point.ply + 1)};
+        Split(perft, child, split_depth, depth, geometry, counts, points);
+    }
+}
+
+///
+/// \brief Reference Same count on SparseTicTacToeBoard, one board copy per move
+///
+void Reference(const SparseTicTacToeBoard& board, const Geometry& geometry, uint8_t ply,
+               uint8_t depth, Counts& counts)
+{
+    ++counts[ply].nodes;
+    if (ply == depth) {
+        return;
+    }
+    auto value = ply % 2 == 0 ? CellValue::X : CellValue::O;
+    for (uint8_t y = 0; y < geometry.Height(); ++y) {
+        for (uint8_t x = 0; x < geometry.Width(); ++x) {
+            if (board.At(x, y).value != CellValue::None) {
+                continue;
+            }
+            SparseTicTacToeBoard child{board};
+            if (child.Place(x, y, value)) {
+                auto& tally = counts[ply + 1];
+                ++tally.nodes;
+                ++(value == CellValue::X ? tally.x_wins : tally.o_wins);
+            }
+            else if (child.StoneCount() == geometry.Cells()) {
+                ++counts[ply + 1].nodes;
+                ++counts[ply + 1].draws;
+            }
+            else {
+                Reference(child, geometry, ply + 1, depth, counts);
+            }
+        }
+    }
+}
+
+///
+/// \brief The GameReference class, the same count with TicTacToeGame deciding the results
+///
+/// Games cannot be copied nor undone, so each node replays its move sequence in one reused
+/// game with both sides forced. The side making the last move is the computer (SetOpening(),
+/// then SetNextMove() before each human move), so that the status is read right after that
+/// move and before any reply of its own. 3x3 only, the board TicTacToeGame plays on.
+///
+class GameReference {
+public:
+    GameReference()
+        : m_status{GameStatus::not_started}
+    {
+        m_game.SetCallback([this](const GameUpdate& update) { m_status = update.status; });
+    }
+
+    ///
+    /// \brief Walk Count a node and its subtree
+    /// \param moves Cell indices of the moves leading to the node
+    /// \param depth
+    /// \param counts
+    ///
+    void Walk(std::vector<uint8_t>& moves, size_t depth, Counts& counts)
+    {
+        auto& tally = counts[moves.size()];
+        ++tally.nodes;
+        switch (moves.empty() ? GameStatus::in_progress : Replay(moves)) {
+        case GameStatus::xs_winner:
+            ++tally.x_wins;
+            return;
+        case GameStatus::os_winner:
+            ++tally.o_wins;
+            return;
+        case GameStatus::draw:
+            ++tally.draws;
+            return;
+        default:
+            break;
+        }
+        if (moves.size() == depth) {
+            return;
+        }
+        for (uint8_t cell = 0; cell < board_size * board_size; ++cell) {
+            if (std::find(moves.begin(), moves.end(), cell) == moves.end()) {
+                moves.push_back(cell);
+                Walk(moves, depth, counts);
+                moves.pop_back();
+            }
+        }
+    }
+
+private:
+    GameStatus Replay(const std::vector<uint8_t>& moves)
+    {
+        auto x = [](uint8_t cell) { return static_cast<uint8_t>(cell % board_size); };
+        auto y = [](uint8_t cell) { return static_cast<uint8_t>(cell / board_size); };
+
+        // X made the last move if there is an odd number of them
+        bool computer_xs = moves.size() % 2 == 1;
+        if (computer_xs) {
+            m_game.SetOpening(x(moves[0]), y(moves[0]));
+        }
+        m_game.Restart(computer_xs ? PlayerSide::os : PlayerSide::xs,
+                       computer_xs ? PlayerType::computer : PlayerType::human,
+                       PolicyKind::normal);
+        for (size_t i = computer_xs ? 1 : 0; i + 1 < moves.size(); i += 2) {
+            m_game.SetNextMove(x(moves[i + 1]), y(moves[i + 1]));
+            m_game.HumanMove(x(moves[i]), y(moves[i]));
+        }
+        return m_status;
+    }
+
+private:
+    TicTacToeGame m_game;
+    GameStatus m_status;
+};
+
+void PrintCounts(const Counts& counts)
+{
+    std::cout << "ply            nodes        x wins        o wins         draws\n";
+    Tally total;
+    for (size_t ply = 0; ply < counts.size(); ++ply) {
+        const auto& t = counts[ply];
+        std::cout << std::setw(3) << ply << std::setw(17) << t.nodes << std::setw(14) << t.x_wins
+                  << std::setw(14) << t.o_wins << std::setw(14) << t.draws << "\n";
+        total.nodes += t.nodes;
+        total.x_wins += t.x_wins;
+        total.o_wins += t.o_wins;
+        total.draws += t.draws;
+    }
+    std::cout << "all" << std::setw(17) << total.nodes << std::setw(14) << total.x_wins
+              << std::setw(14) << total.o_wins << std::setw(14) << total.draws << "\n"
+              << total.Games() << " games\n";
+}
+
+void PrintUsage(const char* program)
+{
+    std::cerr << "usage: " << program
+              << " [--size WxH] [--k N] [--depth N] [--threads N] [--split N] [--memo]"
+                 " [--verify]\n";
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    unsigned long width = board_size, height = board_size, win_length = 0, depth = 0;
+    unsigned long split_depth = 2;
+    size_t threads = std::max(1u, std::thread::hardware_concurrency());
+    bool memo = false, verify = false;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--size" && i + 1 < argc) {
+            char* end = nullptr;
+            width = std::strtoul(argv[++i], &end, 10);
+            height = (*end == 'x') ? std::strtoul(end + 1, nullptr, 10) : 0;
+        }
+        else if (arg == "--k" && i + 1 < argc) {
+            win_length = std::strtoul(argv[++i], nullptr, 10);
+        }
+        else if (arg == "--depth" && i + 1 < argc) {
+            depth = std::strtoul(argv[++i], nullptr, 10);
+        }
+        else if (arg == "--threads" && i + 1 < argc) {
+            threads = std::max(1ul, std::strtoul(argv[++i], nullptr, 10));
+        }
+        else if (arg == "--split" && i + 1 < argc) {
+            split_depth = std::strtoul(argv[++i], nullptr, 10);
+        }
+        else if (arg == "--memo") {
+            memo = true;
+        }
+        else if (arg == "--verify") {
+            verify = true;
+        }
+        else {
+            PrintUsage(argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+    if (win_length == 0) {
+        win_length = std::min(width, height);
+    }
+    if (width == 0 || height == 0 || width * height > 64 || win_length < 1 ||
+        win_length > std::max(width, height)) {
+        std::cerr << "the board must have 1 to 64 cells and k at most its largest side\n";
+        return EXIT_FAILURE;
+    }
+    if (depth == 0 || depth > width * height) {
+        depth = width * height;
+    }
+
+    Geometry geometry{static_cast<uint8_t>(width), static_cast<uint8_t>(height),
+                      static_cast<uint8_t>(win_length)};
+    auto plies = static_cast<uint8_t>(depth);
+    Counts counts(plies + 1);
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<SplitPoint> points;
+    Split(Perft{geometry, plies, memo}, {0, 0, no_cell, 0},
+          threads > 1 ? static_cast<uint8_t>(split_depth) : 0, plies, geometry, counts, points);
+
+    std::atomic<size_t> next{0};
+    std::vector<Counts> thread_counts(threads, Counts(plies + 1));
+    std::vector<std::thread> workers;
+    for (size_t t = 0; t < threads; ++t) {
+        workers.emplace_back([&, t] {
+            Perft perft{geometry, plies, memo};
+            for (size_t i = next++; i < points.size(); i = next++) {
+                const auto& p = points[i];
+                perft.Walk(p.x_stones, p.o_stones, p.last, p.ply, thread_counts[t]);
+            }
+        });
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    for (const auto& c : thread_counts) {
+        Add(counts, c);
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    uint64_t nodes = 0;
+    for (const auto& t : counts) {
+        nodes += t.nodes;
+    }
+    std::cout << width << "x" << height << ", k = " << win_length << ", depth " << depth << ", "
+              << threads << " thread(s)" << (memo ? ", memoized" : "") << "\n";
+    PrintCounts(counts);
+    std::cout << std::fixed << std::setprecision(3) << elapsed.count() << " s, "
+              << std::setprecision(0) << nodes / std::max(elapsed.count(), 1e-9) << " nodes/s\n";
+
+    if (!verify) {
+        return EXIT_SUCCESS;
+    }
+
+    bool ok = true;
+    Counts reference(plies + 1);
+    Reference(SparseTicTacToeBoard{geometry.WinLength()}, geometry, 0, plies, reference);
+    if (reference != counts) {
+        std::cerr << "mismatch with the SparseTicTacToeBoard reference:\n";
+        PrintCounts(reference);
+        ok = false;
+    }
+    if (width == board_size && height == board_size && win_length == board_size) {
+        Counts game_counts(plies + 1);
+        std::vector<uint8_t> moves;
+        GameReference{}.Walk(moves, plies, game_counts);
+        if (game_counts != counts) {
+            std::cerr << "mismatch with the TicTacToeGame reference:\n";
+            PrintCounts(game_counts);
+            ok = false;
+        }
+    }
+    if (width == 3 && height == 3 && win_length == 3 && depth == 9) {
+        Tally total;
+        for (const auto& t : counts) {
+            total.x_wins += t.x_wins;
+            total.o_wins += t.o_wins;
+            total.draws += t.draws;
+        }
+        if (total.x_wins != 131184 || total.o_wins != 77904 || total.draws != 46080) {
+            std::cerr << "mismatch with the known 3x3 results\n";
+            ok = false;
+        }
+    }
+    std::cout << (ok ? "verified\n" : "verification failed\n");
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
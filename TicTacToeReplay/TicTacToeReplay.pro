@@ -0,0 +1,35 @@
+#-------------------------------------------------
+#
+# Record/replay regression gate for TicTacToeCore
+#
+#-------------------------------------------------
+
+QT       -= gui
+
+TARGET = TicTacToeReplay
+TEMPLATE = app
+CONFIG += c++2a
+CONFIG += console
+CONFIG -= app_bundle
+
+DEFINES += QT_DEPRECATED_WARNINGS
+DEFINES += TICTACTOE_CORPUS_DIR=\\\"$$PWD/corpus\\\"
+
+SOURCES += \
+        main.cpp
+
+DISTFILES += \
+        corpus/games.txt \
+        corpus/thresholds.txt
+
+win32:CONFIG(release, debug|release): LIBS += -L$$OUT_PWD/../TicTacToeCore/release/ -lTicTacToeCore
+else:win32:CONFIG(debug, debug|release): LIBS += -L$$OUT_PWD/../TicTacToeCore/debug/ -lTicTacToeCore
+else:unix: LIBS += -L$$OUT_PWD/../TicTacToeCore/ -lTicTacToeCore
+
+INCLUDEPATH += $$PWD/../TicTacToeCore
+DEPENDPATH += $$PWD/../TicTacToeCore
+
+# "make check" runs the gate
+check.commands = $$OUT_PWD/$$TARGET
+check.depends = $$TARGET
+QMAKE_EXTRA_TARGETS += check
@@ -0,0 +1,1201 @@
+/// @file
+///
+/// Replays the recorded games of the corpus through TicTacToeGame and fails on any behavioral
+/// (different computer move or result) or performance (latency, allocations) regression.
+///
+/// Usage:
+///     TicTacToeReplay [corpus_dir]            replay and check
+///     TicTacToeReplay --trace <file> [dir]    same, and write the spans as a Chrome trace
+///                                             (needs a core built with CONFIG+=tracing)
+///     TicTacToeReplay --record <count>        print a new corpus with <count> games per setup
+///
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bitset>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <limits>
+#include <map>
+#include <memory>
+#include <new>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <tictactoe_batch.hpp>
+#include <tictactoe_cache.hpp>
+#include <tictactoe_evaluator.hpp>
+#include <tictactoe_game.hpp>
+#include <tictactoe_memory.hpp>
+#include <tictactoe_session.hpp>
+#include <tictactoe_sparse_board.hpp>
+#include <tictactoe_trace.hpp>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+/// Counted by the replaced operator new, which any thread may call
+std::atomic<size_t> g_allocations{0};
+
+size_t Allocations()
+{
+    return g_allocations.load(std::memory_order_relaxed);
+}
+
+} // namespace
+
+void* operator new(std::size_t size)
+{
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(size == 0 ? 1 : size)) {
+        return p;
+    }
+    throw std::bad_alloc{};
+}
+
+void* operator new[](std::size_t size)
+{
+    return operator new(size);
+}
+
+void operator delete(void* p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete[](void* p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept
+{
+    std::free(p);
+}
+
+void operator delete[](void* p, std::size_t) noexcept
+{
+    std::free(p);
+}
+
+namespace {
+
+using namespace tictactoe;
+using Clock = std::chrono::steady_clock;
+
+///
+/// \brief The Policy struct maps a corpus name to the game settings
+///
+struct Policy {
+    const char* name;
+    PolicyKind kind;
+};
+
+constexpr std::array<Policy, 3> policies{
+    {{"easy", PolicyKind::normal}, {"hard", PolicyKind::impossible}, {"learned", PolicyKind::learned}}};
+
+///
+/// \brief The Move struct
+///
+struct Move {
+    PlayerType player;
+    uint8_t x;
+    uint8_t y;
+};
+
+///
+/// \brief The RecordedGame struct, one line of the corpus
+///
+struct RecordedGame {
+    size_t line{0};
+    std::string policy;
+    PlayerSide human_side{PlayerSide::xs};
+    PlayerType first_player{PlayerType::human};
+    uint32_t seed{0};
+    std::vector<Move> moves;
+    std::string result;
+};
+
+///
+/// \brief The Thresholds struct, performance limits stored next to the corpus
+///
+struct Thresholds {
+    size_t repeats{5};
+    double max_mean_move_ns{0};
+    double max_move_ns{0};
+    size_t max_start_allocs{0};
+    size_t max_restart_allocs{0};
+    size_t max_move_allocs{0};
+    double max_span_ns{0};
+};
+
+///
+/// \brief The Measurements struct
+///
+struct Measurements {
+    size_t moves{0};
+    double total_move_ns{0};
+    double max_move_ns{0};
+    size_t max_start_allocs{0};
+    size_t max_restart_allocs{0};
+    size_t max_move_allocs{0};
+};
+
+const char* StatusName(GameStatus status)
+{
+    switch (status) {
+    case GameStatus::not_started:
+        return "not_started";
+    case GameStatus::in_progress:
+        return "in_progress";
+    case GameStatus::draw:
+        return "draw";
+    case GameStatus::xs_winner:
+        return "xs_winner";
+    case GameStatus::os_winner:
+        return "os_winner";
+    }
+    return "unknown";
+}
+
+const Policy* FindPolicy(const std::string& name)
+{
+    auto it = std::find_if(policies.begin(), policies.end(),
+                           [&name](const Policy& p) { return name == p.name; });
+    return it != policies.end() ? &*it : nullptr;
+}
+
+///
+/// \brief The ReplaySession class wraps a game and collects the cells changed by its updates
+///
+class ReplaySession {
+public:
+    ReplaySession()
+        : m_status{GameStatus::not_started}
+        , m_changed{0}
+        , m_callback{[this](const GameUpdate& update) {
+            m_status = update.status;
+            m_changed |= update.changed_cells;
+        }}
+    {
+        m_game.SetCallback(m_callback);
+    }
+
+    ///
+    /// \brief Start Start a game through TicTacToeGame::Start(), which copies the callback
+    ///
+    void Start(const Policy& policy, PlayerSide human_side, PlayerType first_player,
+               uint32_t seed)
+    {
+        m_game.Seed(seed);
+        m_changed = 0;
+        m_game.Start(human_side, first_player, m_callback, policy.kind);
+    }
+
+    ///
+    /// \brief Restart Start a game through TicTacToeGame::Restart(), keeping the callback
+    ///
+    void Restart(const Policy& policy, PlayerSide human_side, PlayerType first_player,
+                 uint32_t seed)
+    {
+        m_game.Seed(seed);
+        m_changed = 0;
+        m_game.Restart(human_side, first_player, policy.kind);
+    }
+
+    void HumanMove(uint8_t x, uint8_t y)
+    {
+        m_changed = 0;
+        m_game.HumanMove(x, y);
+    }
+
+    bool IsFree(uint8_t x, uint8_t y) const
+    {
+        return m_game.GetCell(x, y).value == CellValue::None;
+    }
+
+    ///
+    /// \brief ComputerReply Find the cell the computer took in the last Start() or HumanMove()
+    /// \param human_x Cell the human took (ignored), npos if none
+    /// \param human_y
+    /// \param move
+    /// \return False if the computer did not move
+    ///
+    bool ComputerReply(uint8_t human_x, uint8_t human_y, Move& move) const
+    {
+        for (uint8_t y = 0; y < board_size; ++y) {
+            for (uint8_t x = 0; x < board_size; ++x) {
+                // Start() reports the whole board as changed, only the taken cells count
+                if ((x != human_x || y != human_y) && (m_changed & CellBit(x, y)) &&
+                    m_game.GetCell(x, y).value != CellValue::None) {
+                    move = {PlayerType::computer, x, y};
+                    return true;
+                }
+            }
+        }
+        return false;
+    }
+
+    GameStatus Status() const { return m_status; }
+
+private:
+    TicTacToeGame m_game;
+    GameStatus m_status;
+    CellMask m_changed;
+    GameUpdateCalback m_callback;
+};
+
+bool ParseMove(const std::string& token, Move& move)
+{
+    if (token.size() != 3 || (token[0] != 'h' && token[0] != 'c') || token[1] < '0' ||
+        token[1] >= '0' + board_size || token[2] < '0' || token[2] >= '0' + board_size) {
+        return false;
+    }
+    move.player = token[0] == 'h' ? PlayerType::human : PlayerType::computer;
+    move.x = static_cast<uint8_t>(token[1] - '0');
+    move.y = static_cast<uint8_t>(token[2] - '0');
+    return true;
+}
+
+std::string FormatMove(const Move& move)
+{
+    std::string str{move.player == PlayerType::human ? 'h' : 'c'};
+    str += static_cast<char>('0' + move.x);
+    str += static_cast<char>('0' + move.y);
+    return str;
+}
+
+bool LoadCorpus(const std::string& path, std::vector<RecordedGame>& games)
+{
+    std::ifstream file{path};
+    if (!file) {
+        std::cerr << "cannot open " << path << "\n";
+        return false;
+    }
+
+    std::string text;
+    size_t line = 0;
+    while (std::getline(file, text)) {
+        ++line;
+        if (text.empty() || text[0] == '#') {
+            continue;
+        }
+
+        // <policy> <xs|os> <human|computer> <seed> <moves...> = <result>
+        std::istringstream in{text};
+        RecordedGame game;
+        std::string side, first, token;
+        game.line = line;
+        in >> game.policy >> side >> first >> game.seed;
+        game.human_side = side == "os" ? PlayerSide::os : PlayerSide::xs;
+        game.first_player = first == "computer" ? PlayerType::computer : PlayerType::human;
+
+        bool valid = in && FindPolicy(game.policy) && (side == "xs" || side == "os") &&
+                     (first == "human" || first == "computer");
+        while (valid && in >> token && token != "=") {
+            Move move;
+            valid = ParseMove(token, move);
+            game.moves.push_back(move);
+        }
+        valid = valid && token == "=" && (in >> game.result);
+        if (!valid) {
+            std::cerr << path << ":" << line << ": malformed game\n";
+            return false;
+        }
+        games.push_back(std::move(game));
+    }
+    return true;
+}
+
+bool LoadThresholds(const std::string& path, Thresholds& thresholds)
+{
+    std::ifstream file{path};
+    if (!file) {
+        std::cerr << "cannot open " << path << "\n";
+        return false;
+    }
+
+    std::string key;
+    while (file >> key) {
+        if (key[0] == '#') {
+            std::getline(file, key);
+        }
+        else if (key == "repeats") {
+            file >> thresholds.repeats;
+        }
+        else if (key == "max_mean_move_ns") {
+            file >> thresholds.max_mean_move_ns;
+        }
+        else if (key == "max_move_ns") {
+            file >> thresholds.max_move_ns;
+        }
+        else if (key == "max_start_allocs") {
+            file >> thresholds.max_start_allocs;
+        }
+        else if (key == "max_restart_allocs") {
+            file >> thresholds.max_restart_allocs;
+        }
+        else if (key == "max_move_allocs") {
+            file >> thresholds.max_move_allocs;
+        }
+        else if (key == "max_span_ns") {
+            file >> thresholds.max_span_ns;
+        }
+        else {
+            std::cerr << path << ": unknown threshold " << key << "\n";
+            return false;
+        }
+    }
+    return true;
+}
+
+///
+/// \brief Replay Play a recorded game and compare every computer move
+/// \param recorded
+/// \param measurements
+/// \param policy Played instead of the recorded policy, if not null
+/// \return False on behavioral mismatch
+///
+bool Replay(const RecordedGame& recorded, Measurements& measurements,
+            const Policy* policy = nullptr)
+{
+    ReplaySession session;
+    Move reply{};
+
+    // Both ways to begin a game are measured, the game is then replayed from Restart()
+    const auto& played = policy ? *policy : *FindPolicy(recorded.policy);
+    auto allocations = Allocations();
+    session.Start(played, recorded.human_side, recorded.first_player, recorded.seed);
+    measurements.max_start_allocs =
+        std::max(measurements.max_start_allocs, Allocations() - allocations);
+
+    allocations = Allocations();
+    session.Restart(played, recorded.human_side, recorded.first_player, recorded.seed);
+    measurements.max_restart_allocs =
+        std::max(measurements.max_restart_allocs, Allocations() - allocations);
+
+    auto expect_reply = [&](size_t i, uint8_t human_x, uint8_t human_y) {
+        bool moved = session.ComputerReply(human_x, human_y, reply);
+        bool expected = i < recorded.moves.size() &&
+                        recorded.moves[i].player == PlayerType::computer;
+        if (moved != expected || (moved && (reply.x != recorded.moves[i].x ||
+                                            reply.y != recorded.moves[i].y))) {
+            std::cerr << "line " << recorded.line << ", move " << i + 1 << ": expected "
+                      << (expected ? FormatMove(recorded.moves[i]) : "no reply") << ", got "
+                      << (moved ? FormatMove(reply) : "no reply") << "\n";
+            return false;
+        }
+        return true;
+    };
+
+    size_t i = 0;
+    if (recorded.first_player == PlayerType::computer) {
+        if (!expect_reply(i, TicTacToeGame::npos, TicTacToeGame::npos)) {
+            return false;
+        }
+        ++i;
+    }
+    while (i < recorded.moves.size()) {
+        const auto& move = recorded.moves[i++];
+        if (move.player != PlayerType::human || !session.IsFree(move.x, move.y)) {
+            std::cerr << "line " << recorded.line << ", move " << i << ": "
+                      << FormatMove(move) << " cannot be played\n";
+            return false;
+        }
+
+        allocations = Allocations();
+        auto start = Clock::now();
+        session.HumanMove(move.x, move.y);
+        double ns = std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+        measurements.max_move_allocs =
+            std::max(measurements.max_move_allocs, Allocations() - allocations);
+        measurements.total_move_ns += ns;
+        measurements.max_move_ns = std::max(measurements.max_move_ns, ns);
+        ++measurements.moves;
+
+        if (!expect_reply(i, move.x, move.y)) {
+            return false;
+        }
+        if (i < recorded.moves.size() && recorded.moves[i].player == PlayerType::computer) {
+            ++i;
+        }
+    }
+
+    if (recorded.result != StatusName(session.Status())) {
+        std::cerr << "line " << recorded.line << ": expected " << recorded.result << ", got "
+                  << StatusName(session.Status()) << "\n";
+        return false;
+    }
+    return true;
+}
+
+///
+/// \brief Record Play random human moves against every policy and print the corpus
+/// \param count Number of games per policy, side and first player
+///
+void Record(size_t count)
+{
+    std::cout << "# <policy> <xs|os> <human|computer> <seed> <moves...> = <result>\n";
+
+    uint32_t seed = 1;
+    for (const auto& policy : policies) {
+        for (auto side : {PlayerSide::xs, PlayerSide::os}) {
+            for (auto first : {PlayerType::human, PlayerType::computer}) {
+                for (size_t n = 0; n < count; ++n, ++seed) {
+                    ReplaySession session;
+                    std::mt19937 human{seed};
+                    std::vector<Move> moves;
+                    Move reply{};
+
+                    session.Start(policy, side, first, seed);
+                    if (session.ComputerReply(TicTacToeGame::npos, TicTacToeGame::npos, reply)) {
+                        moves.push_back(reply);
+                    }
+                    while (session.Status() == GameStatus::in_progress) {
+                        std::vector<Move> free;
+                        for (uint8_t y = 0; y < board_size; ++y) {
+                            for (uint8_t x = 0; x < board_size; ++x) {
+                                if (session.IsFree(x, y)) {
+                                    free.push_back({PlayerType::human, x, y});
+                                }
+                            }
+                        }
+                        auto move = free[human() % free.size()];
+                        moves.push_back(move);
+                        session.HumanMove(move.x, move.y);
+                        if (session.ComputerReply(move.x, move.y, reply)) {
+                            moves.push_back(reply);
+                        }
+                    }
+
+                    std::cout << policy.name << (side == PlayerSide::xs ? " xs " : " os ")
+                              << (first == PlayerType::human ? "human " : "computer ") << seed;
+                    for (const auto& move : moves) {
+                        std::cout << " " << FormatMove(move);
+                    }
+                    std::cout << " = " << StatusName(session.Status()) << "\n";
+                }
+            }
+        }
+    }
+}
+
+///
+/// \brief CheckSparseArena Play a long game on a sparse board backed by a fixed arena
+/// \return False if anything was allocated outside of the arena
+///
+bool CheckSparseArena()
+{
+    static std::array<std::byte, 1 << 20> buffer;
+    CountingMemoryResource overflow{std::pmr::null_memory_resource()};
+    std::pmr::monotonic_buffer_resource arena{buffer.data(), buffer.size(), &overflow};
+
+    auto allocations = Allocations();
+    try {
+        SparseTicTacToeBoard board{5, &arena};
+        std::mt19937 rng{1};
+        auto side = CellValue::X;
+        for (int i = 0; i < 1000; ++i) {
+            board.ForEachCandidate(
+                [&rng](SparseCell& cell) { cell.attack_points = static_cast<uint8_t>(rng() % 8); });
+            auto& cell = board.MaxScoreCell();
+            board.Place(cell.x, cell.y, side);
+            side = (side == CellValue::X) ? CellValue::O : CellValue::X;
+        }
+    }
+    catch (const std::bad_alloc&) {
+        std::cerr << "sparse board outgrew its arena\n";
+        return false;
+    }
+
+    std::cout << "sparse arena: " << Allocations() - allocations << " heap allocs\n";
+    return Allocations() == allocations && overflow.Allocations() == 0;
+}
+
+///
+/// \brief CheckEvaluatorKernels Compare the SIMD and portable evaluator kernels
+///
+/// The built-in weights are dotted with random accumulators, half of them over the whole
+/// int16 range and half around the clipping bounds.
+/// \return False if the kernels disagree
+///
+bool CheckEvaluatorKernels()
+{
+    Evaluator evaluator;
+    std::mt19937 rng{1};
+    std::uniform_int_distribution<int> wide{std::numeric_limits<int16_t>::min(),
+                                            std::numeric_limits<int16_t>::max()};
+    std::uniform_int_distribution<int> narrow{-2 * Evaluator::activation_max,
+                                              2 * Evaluator::activation_max};
+    constexpr size_t samples = 100000;
+    size_t mismatches = 0;
+    Evaluator::Accumulator accumulator;
+    for (size_t i = 0; i < samples; ++i) {
+        for (auto& value : accumulator.values) {
+            value = static_cast<int16_t>(i % 2 == 0 ? wide(rng) : narrow(rng));
+        }
+        if (evaluator.Evaluate(accumulator) != evaluator.EvaluateScalar(accumulator)) {
+            ++mismatches;
+        }
+    }
+
+    std::cout << "kernels:      " << samples << " evaluations, ";
+    if (Evaluator::HasSimdKernel()) {
+        std::cout << mismatches << " AVX2/scalar mismatches\n";
+    }
+    else {
+        std::cout << "no SIMD kernel on this CPU\n";
+    }
+    return mismatches == 0;
+}
+
+///
+/// \brief CheckTraceOverhead Time an enabled trace span on the calling thread
+///
+/// The span cost is split into its two timestamps, timed alone, and the recording into the
+/// thread buffer.
+/// \param max_span_ns
+/// \return False if a span is slower than max_span_ns
+///
+bool CheckTraceOverhead(double max_span_ns)
+{
+    constexpr size_t spans = size_t{1} << 20;
+    bool enabled = Tracer::Enabled();
+    Tracer::Enable(true);
+
+    auto start = Clock::now();
+    for (size_t i = 0; i < spans; ++i) {
+        TraceScope scope{"span"};
+    }
+    double span_ns =
+        std::chrono::duration<double, std::nano>(Clock::now() - start).count() / spans;
+
+    volatile uint64_t sink = 0;
+    start = Clock::now();
+    for (size_t i = 0; i < spans; ++i) {
+        auto begin = Tracer::Now();
+        sink = sink + (Tracer::Now() - begin);
+    }
+    double timestamps_ns =
+        std::chrono::duration<double, std::nano>(Clock::now() - start).count() / spans;
+
+    Tracer::Clear();
+    Tracer::Enable(enabled);
+    std::cout << "trace span:   " << span_ns << " ns (" << timestamps_ns << " ns timestamps, "
+              << std::max(span_ns - timestamps_ns, 0.0) << " ns recording, max " << max_span_ns
+              << " ns)\n";
+    return span_ns <= max_span_ns;
+}
+
+///
+/// \brief RandomMove Pick one of the empty cells
+/// \return The cell index
+///
+uint8_t RandomMove(CellMask empty, std::minstd_rand& rng)
+{
+    auto n = rng() % std::bitset<16>(empty).count();
+    for (uint8_t cell = 0;; ++cell) {
+        if ((empty & (1u << cell)) && n-- == 0) {
+            return cell;
+        }
+    }
+}
+
+///
+/// \brief CheckBatch Play random games on GameBatch and one by one on TicTacToeGame
+/// \return False if a game ends differently
+///
+bool CheckBatch()
+{
+    constexpr size_t count = 4096;
+    std::chrono::nanoseconds batch_time{0};
+    size_t batch_moves = 0;
+
+    for (auto kind : {PolicyKind::normal, PolicyKind::impossible}) {
+        for (auto side : {PlayerSide::xs, PlayerSide::os}) {
+            for (auto first : {PlayerType::human, PlayerType::computer}) {
+                std::vector<std::minstd_rand> humans;
+                for (uint32_t i = 0; i < count; ++i) {
+                    humans.emplace_back(i + 1);
+                }
+                GameBatch batch;
+                batch.Start(count, side, first, kind, 1);
+                std::vector<uint8_t> moves(count);
+                while (batch.Active() > 0) {
+                    auto lanes = batch.Active();
+                    if (batch.ToMove() == PlayerType::human) {
+                        for (size_t lane = 0; lane < lanes; ++lane) {
+                            moves[lane] = RandomMove(batch.EmptyCells(lane),
+                                                     humans[batch.Game(lane)]);
+                        }
+                        auto start = std::chrono::steady_clock::now();
+                        batch.HumanMoves(moves.data());
+                        batch_time += std::chrono::steady_clock::now() - start;
+                    }
+                    else {
+                        auto start = std::chrono::steady_clock::now();
+                        batch.ComputerMoves();
+                        batch_time += std::chrono::steady_clock::now() - start;
+                    }
+                    batch_moves += lanes;
+                }
+
+                TicTacToeGame game;
+                for (uint32_t i = 0; i < count; ++i) {
+                    std::minstd_rand human{i + 1};
+                    GameStatus status = GameStatus::not_started;
+                    game.SetCallback([&status](const GameUpdate& update) { status = update.status; });
+                    game.Seed(1 + i);
+                    game.Restart(side, first, kind);
+                    while (status == GameStatus::in_progress) {
+                        auto key = Encode(game);
+                        auto move = RandomMove(~(XStones(key) | OStones(key)) & all_cells, human);
+                        game.HumanMove(move % board_size, move / board_size);
+                    }
+                    const auto& result = batch.Results()[i];
+                    if (result.status != status || result.position != Encode(game)) {
+                        std::cerr << "batch game " << i << " diverged from TicTacToeGame\n";
+                        return false;
+                    }
+                }
+            }
+        }
+    }
+
+    std::cout << "batch:        " << batch_moves << " moves match TicTacToeGame, "
+              << batch_moves * 1e3 / std::max<int64_t>(batch_time.count(), 1) << " M moves/s\n";
+    return true;
+}
+
+///
+/// \brief CheckConfigured Replay the easy and hard games on the configured policy
+///
+/// The normal and impossible parameters must play exactly like their policies, parsed back
+/// from a configuration as well, and a game must keep the parameters it started with when
+/// others are published in the middle of it.
+/// \return False on a mismatch
+///
+bool CheckConfigured(const std::vector<RecordedGame>& games)
+{
+    constexpr Policy configured{"configured", PolicyKind::configured};
+
+    std::istringstream config{"# impossible\n"
+                              "win_attack_points 20\n"
+                              "win_attack_increment 0\n"
+                              "defense_points 0\n"
+                              "defense_per_enemy 1\n"
+                              "danger_defense_points 10\n"};
+    PolicyParameters impossible;
+    std::string error;
+    if (!impossible.Read(config, &error)) {
+        std::cerr << "configuration: " << error << "\n";
+        return false;
+    }
+
+    const std::pair<std::string, PolicyParameters> settings[] = {
+        {"easy", PolicyParameters::Normal()}, {"hard", impossible}};
+    Measurements measurements;
+    size_t replayed = 0;
+    for (const auto& setting : settings) {
+        PolicyConfig::Publish(setting.second);
+        for (const auto& game : games) {
+            if (game.policy == setting.first) {
+                if (!Replay(game, measurements, &configured)) {
+                    return false;
+                }
+                ++replayed;
+            }
+        }
+    }
+
+    // Hot reload: publish other parameters after every move of a configured game
+    TicTacToeGame game, reference;
+    GameStatus status = GameStatus::not_started;
+    game.SetCallback([&status](const GameUpdate& update) { status = update.status; });
+    for (uint32_t i = 0; i < 256; ++i) {
+        std::minstd_rand human{i + 1};
+        PolicyConfig::Publish(PolicyParameters::Normal());
+        game.Seed(1 + i);
+        game.Restart(PlayerSide::os, PlayerType::computer, PolicyKind::configured);
+        reference.Seed(1 + i);
+        reference.Restart(PlayerSide::os, PlayerType::computer, PolicyKind::normal);
+        while (status == GameStatus::in_progress) {
+            PolicyConfig::Publish(i % 2 ? impossible : PolicyParameters::Normal());
+            auto key = Encode(game);
+            auto move = RandomMove(~(XStones(key) | OStones(key)) & all_cells, human);
+            game.HumanMove(move % board_size, move / board_size);
+            reference.HumanMove(move % board_size, move / board_size);
+            if (Encode(game) != Encode(reference)) {
+                std::cerr << "configured game " << i << " did not keep its parameters\n";
+                return false;
+            }
+        }
+    }
+    PolicyConfig::Publish(PolicyParameters{});
+
+    // The levels reload too: the normal policy published with the hard parameters replays
+    // the hard games
+    constexpr Policy retuned{"normal", PolicyKind::normal};
+    PolicyConfig::Publish(impossible, PolicyKind::normal);
+    size_t retuned_games = 0;
+    bool retuned_matches = true;
+    for (const auto& game : games) {
+        if (retuned_matches && game.policy == "hard") {
+            retuned_matches = Replay(game, measurements, &retuned);
+            ++retuned_games;
+        }
+    }
+    PolicyConfig::Publish(PolicyParameters::Normal(), PolicyKind::normal);
+    if (!retuned_matches) {
+        std::cerr << "the normal policy did not play its published parameters\n";
+        return false;
+    }
+
+    std::cout << "configured:   " << replayed << " games match easy and hard, "
+              << measurements.max_start_allocs + measurements.max_restart_allocs +
+                     measurements.max_move_allocs
+              << " allocs, reloads pinned, " << retuned_games << " retuned normal games\n";
+    return measurements.max_start_allocs == 0 && measurements.max_restart_allocs == 0 &&
+           measurements.max_move_allocs == 0;
+}
+
+///
+/// \brief CheckLevels Time the difficulty levels and check that the strongest one never loses
+///
+/// Every human move sequence is played against the last level, from both sides and after
+/// every computer opening.
+/// \return False if a human line beats it
+///
+bool CheckLevels()
+{
+    TicTacToeGame game;
+    GameStatus status = GameStatus::not_started;
+    game.SetCallback([&status](const GameUpdate& update) { status = update.status; });
+
+    std::cout << "levels:      ";
+    for (const auto& level : difficulty_levels) {
+        std::minstd_rand human{1};
+        size_t moves = 0;
+        auto start = Clock::now();
+        for (uint32_t i = 0; i < 1000; ++i) {
+            game.Seed(1 + i);
+            game.Restart(PlayerSide::xs, PlayerType::human, level.difficulty);
+            while (status == GameStatus::in_progress) {
+                auto key = Encode(game);
+                auto move = RandomMove(~(XStones(key) | OStones(key)) & all_cells, human);
+                game.HumanMove(move % board_size, move / board_size);
+                ++moves;
+            }
+        }
+        std::cout << " " << level.name << " "
+                  << std::chrono::duration<double, std::nano>(Clock::now() - start).count() /
+                         moves
+                  << " ns";
+    }
+    std::cout << " per move\n";
+
+    const auto& strongest = difficulty_levels.back().difficulty;
+    size_t lines = 0;
+    std::vector<uint8_t> played;
+    // Depth first over the human moves, replaying the line from the start at each node
+    std::function<bool(PlayerSide, uint8_t)> explore = [&](PlayerSide side, uint8_t opening) {
+        bool computer_first = opening != TicTacToeGame::npos;
+        if (computer_first) {
+            game.SetOpening(opening % board_size, opening / board_size);
+        }
+        game.Restart(side, computer_first ? PlayerType::computer : PlayerType::human, strongest);
+        for (auto move : played) {
+            game.HumanMove(move % board_size, move / board_size);
+        }
+        if (status != GameStatus::in_progress) {
+            ++lines;
+            return status != (side == PlayerSide::xs ? GameStatus::xs_winner
+                                                     : GameStatus::os_winner);
+        }
+        auto key = Encode(game);
+        for (CellMask empty = ~(XStones(key) | OStones(key)) & all_cells; empty != 0;
+             empty &= empty - 1) {
+            played.push_back(static_cast<uint8_t>(std::bitset<16>((empty & -empty) - 1).count()));
+            bool held = explore(side, opening);
+            played.pop_back();
+            if (!held) {
+                return false;
+            }
+        }
+        return true;
+    };
+
+    bool unbeaten = explore(PlayerSide::xs, TicTacToeGame::npos);
+    for (uint8_t opening = 0; unbeaten && opening < board_size * board_size; ++opening) {
+        unbeaten = explore(PlayerSide::os, opening);
+    }
+    game.SetOpening(TicTacToeGame::npos, TicTacToeGame::npos);
+    if (!unbeaten) {
+        std::cerr << difficulty_levels.back().name << " lost a game\n";
+        return false;
+    }
+    std::cout << "              " << difficulty_levels.back().name << " unbeaten in " << lines
+              << " human lines\n";
+    return true;
+}
+
+#if defined(__unix__) || defined(__APPLE__)
+///
+/// \brief CheckCacheStress Store and find from 8 threads in a 64 entry table
+///
+/// Far more positions than entries, so the threads keep replacing each other's entries. A hit
+/// must return the result stored for that position.
+/// \param name Segment name
+/// \return The number of hits, 0 on a torn read
+///
+size_t CheckCacheStress(const std::string& name)
+{
+    struct Position {
+        CellMask own;
+        CellMask opponent;
+        SearchResult result;
+    };
+
+    // Random positions without a line, with their complete search results
+    std::vector<Position> positions;
+    std::minstd_rand rng{1};
+    while (positions.size() < 512) {
+        CellMask stones[2] = {0, 0};
+        auto plies = rng() % (board_size * board_size);
+        for (size_t ply = 0; ply < plies; ++ply) {
+            auto move = RandomMove(~(stones[0] | stones[1]) & all_cells, rng);
+            stones[ply % 2] |= CellBit(move % board_size, move / board_size);
+        }
+        if (HasLine(stones[0]) || HasLine(stones[1])) {
+            continue;
+        }
+        auto& own = stones[plies % 2];
+        auto& opponent = stones[1 - plies % 2];
+        positions.push_back(
+            {own, opponent, Search(own, opponent, board_size * board_size, 1u << 20)});
+    }
+
+    EvaluationCache::Remove(name);
+    EvaluationCache cache;
+    std::string error;
+    if (!cache.Open(name, 64, &error)) {
+        std::cerr << "cache: " << error << "\n";
+        return 0;
+    }
+    std::atomic<size_t> hits{0}, torn{0};
+    std::vector<std::thread> threads;
+    for (uint32_t t = 0; t < 8; ++t) {
+        threads.emplace_back([&, t] {
+            std::minstd_rand thread_rng{t + 1};
+            size_t thread_hits = 0, thread_torn = 0;
+            for (size_t i = 0; i < 200000; ++i) {
+                const auto& position = positions[thread_rng() % positions.size()];
+                SearchResult found;
+                if (thread_rng() % 2 == 0) {
+                    cache.Store(position.own, position.opponent, board_size * board_size,
+                                position.result);
+                }
+                else if (cache.Find(position.own, position.opponent, board_size * board_size,
+                                    found)) {
+                    ++thread_hits;
+                    if (found.wins != position.result.wins ||
+                        found.safe != position.result.safe) {
+                        ++thread_torn;
+                    }
+                }
+            }
+            hits += thread_hits;
+            torn += thread_torn;
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    cache.Close();
+    EvaluationCache::Remove(name);
+
+    if (torn > 0) {
+        std::cerr << "cache: " << torn << " torn reads out of " << hits << " hits\n";
+        return 0;
+    }
+    return hits;
+}
+
+///
+/// \brief CheckAbandonedSegments Open over the leftovers of creators that died early
+/// \param name Segment name
+/// \return False if a leftover made the cache unusable
+///
+bool CheckAbandonedSegments(const std::string& name)
+{
+    // Created but never sized, then sized but never initialized
+    for (bool sized : {false, true}) {
+        EvaluationCache::Remove(name);
+        int fd = shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+        if (fd < 0 || (sized && ftruncate(fd, 1 << 12) != 0)) {
+            std::cerr << "cache: cannot create a leftover segment\n";
+            return false;
+        }
+        close(fd);
+
+        EvaluationCache cache;
+        std::string error;
+        bool opened = cache.Open(name, 64, &error);
+        if (opened) {
+            // A fresh cache: empty and writable
+            SearchResult result;
+            cache.Store(0, 0, 1, {1, 1, 0, true});
+            opened = cache.Find(0, 0, 1, result) && result.wins == 1;
+        }
+        cache.Close();
+        EvaluationCache::Remove(name);
+        if (!opened) {
+            std::cerr << "cache: " << (sized ? "uninitialized" : "unsized")
+                      << " leftover not recovered: " << error << "\n";
+            return false;
+        }
+    }
+    return true;
+}
+#endif
+
+///
+/// \brief CheckCache Play the strongest level with and without a shared memory cache
+///
+/// The cache is opened, played into, closed and opened again like after a restart.
+/// \return False if the cache changes a move or cannot be opened
+///
+bool CheckCache()
+{
+#if defined(__unix__) || defined(__APPLE__)
+    const auto& strongest = difficulty_levels.back().difficulty;
+    // Plays the same random games each time, returns the time per move and the final positions
+    auto play = [&strongest](std::vector<PositionKey>& positions) {
+        TicTacToeGame game;
+        GameStatus status = GameStatus::not_started;
+        game.SetCallback([&status](const GameUpdate& update) { status = update.status; });
+        std::minstd_rand human{1};
+        size_t moves = 0;
+        positions.clear();
+        auto start = Clock::now();
+        for (uint32_t i = 0; i < 200; ++i) {
+            game.Seed(1 + i);
+            game.Restart(PlayerSide::xs, PlayerType::human, strongest);
+            while (status == GameStatus::in_progress) {
+                auto key = Encode(game);
+                auto move = RandomMove(~(XStones(key) | OStones(key)) & all_cells, human);
+                game.HumanMove(move % board_size, move / board_size);
+                ++moves;
+            }
+            positions.push_back(Encode(game));
+        }
+        return std::chrono::duration<double, std::nano>(Clock::now() - start).count() / moves;
+    };
+
+    const std::string name = "/tictactoe-replay-" + std::to_string(std::random_device{}());
+    EvaluationCache::Remove(name);
+    std::vector<PositionKey> expected, cold, warm;
+    auto uncached_ns = play(expected);
+
+    std::string error;
+    EvaluationCache cache;
+    if (!cache.Open(name, 1 << 14, &error)) {
+        std::cerr << "cache: " << error << "\n";
+        return false;
+    }
+    EvaluationCache::Install(&cache);
+    auto cold_ns = play(cold);
+    cache.Close();
+
+    // A new mapping of the same segment, as a restarted process would get
+    EvaluationCache restarted;
+    bool reopened = restarted.Open(name, 1 << 14, &error);
+    EvaluationCache::Install(&restarted);
+    auto warm_ns = reopened ? play(warm) : 0;
+    EvaluationCache::Install(nullptr);
+    restarted.Close();
+    EvaluationCache::Remove(name);
+
+    if (!reopened || cold != expected || warm != expected) {
+        std::cerr << "cache: " << (reopened ? "the cache changed the games" : error) << "\n";
+        return false;
+    }
+
+    auto hits = CheckCacheStress(name);
+    if (hits == 0 || !CheckAbandonedSegments(name)) {
+        return false;
+    }
+    std::cout << "cache:        " << difficulty_levels.back().name << " " << uncached_ns
+              << " ns uncached, " << cold_ns << " ns cold, " << warm_ns
+              << " ns after reopening, per move\n"
+              << "              8 threads on 64 entries: " << hits
+              << " hits, no torn read; abandoned segments recovered\n";
+    return true;
+#else
+    // No POSIX shared memory
+    return true;
+#endif
+}
+
+///
+/// \brief CheckSessions Play all the recorded games at once as coroutines on one executor
+/// \return False if a game ends differently than recorded
+///
+bool CheckSessions(const std::vector<RecordedGame>& games)
+{
+    QueueExecutor executor;
+    std::vector<std::unique_ptr<Session>> sessions;
+    std::vector<Task<GameStatus>> tasks;
+    std::vector<size_t> next_move(games.size(), 0);
+
+    for (const auto& game : games) {
+        sessions.push_back(std::make_unique<Session>(executor, game.human_side,
+                                                     game.first_player,
+                                                     FindPolicy(game.policy)->kind));
+        sessions.back()->Game().Seed(game.seed);
+        tasks.push_back(PlayGame(*sessions.back()));
+        tasks.back().Start();
+    }
+
+    // Feed one human move to every waiting game per round, like a server receiving requests
+    for (bool pending = true; pending;) {
+        executor.Run();
+        pending = false;
+        for (size_t i = 0; i < games.size(); ++i) {
+            if (!sessions[i]->AwaitingMove()) {
+                continue;
+            }
+            const auto& moves = games[i].moves;
+            auto& n = next_move[i];
+            while (n < moves.size() && moves[n].player != PlayerType::human) {
+                ++n;
+            }
+            if (n == moves.size() || !sessions[i]->SubmitMove(moves[n].x, moves[n].y)) {
+                std::cerr << "line " << games[i].line << ": session rejected move " << n + 1
+                          << "\n";
+                return false;
+            }
+            ++n;
+            pending = true;
+        }
+    }
+
+    for (size_t i = 0; i < games.size(); ++i) {
+        if (!tasks[i].Done() || games[i].result != StatusName(tasks[i].Result())) {
+            std::cerr << "line " << games[i].line << ": session ended with "
+                      << StatusName(sessions[i]->Status()) << "\n";
+            return false;
+        }
+    }
+    std::cout << "sessions:     " << games.size() << " coroutine games, "
+              << sizeof(Session) << " bytes per session\n";
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    if (argc == 3 && std::string{argv[1]} == "--record") {
+        Record(std::strtoul(argv[2], nullptr, 10));
+        return EXIT_SUCCESS;
+    }
+
+    std::string trace_path;
+    if (argc >= 3 && std::string{argv[1]} == "--trace") {
+        trace_path = argv[2];
+        argv += 2;
+        argc -= 2;
+        Tracer::Enable(true);
+    }
+
+    std::string dir = argc > 1 ? argv[1] : TICTACTOE_CORPUS_DIR;
+    std::vector<RecordedGame> games;
+    Thresholds thresholds;
+    if (!LoadCorpus(dir + "/games.txt", games) ||
+        !LoadThresholds(dir + "/thresholds.txt", thresholds)) {
+        return EXIT_FAILURE;
+    }
+
+    // Behavior is checked on every repeat, timings are kept from the fastest one
+    Measurements best;
+    size_t failures = 0;
+    for (size_t repeat = 0; repeat < std::max<size_t>(thresholds.repeats, 1); ++repeat) {
+        Measurements measurements;
+        for (const auto& game : games) {
+            if (!Replay(game, measurements)) {
+                ++failures;
+            }
+        }
+        if (failures > 0) {
+            break;
+        }
+        if (repeat == 0 || measurements.total_move_ns < best.total_move_ns) {
+            best = measurements;
+        }
+    }
+
+    if (!trace_path.empty()) {
+        std::ofstream trace{trace_path};
+        Tracer::WriteChromeTrace(trace);
+        if (!trace) {
+            std::cerr << "cannot write " << trace_path << "\n";
+        }
+    }
+
+    if (failures > 0) {
+        std::cerr << failures << " of " << games.size() << " games diverged\n";
+        return EXIT_FAILURE;
+    }
+    const std::pair<const char*, std::function<bool()>> checks[] = {
+        {"sessions", [&games] { return CheckSessions(games); }},
+        {"batch", CheckBatch},
+        {"configured", [&games] { return CheckConfigured(games); }},
+        {"levels", CheckLevels},
+        {"cache", CheckCache},
+        {"sparse arena", CheckSparseArena},
+        {"evaluator kernels", CheckEvaluatorKernels},
+        {"trace overhead", [&thresholds] { return CheckTraceOverhead(thresholds.max_span_ns); }},
+    };
+    for (const auto& check : checks) {
+        if (!check.second()) {
+            std::cerr << check.first << " check failed\n";
+            return EXIT_FAILURE;
+        }
+    }
+
+    double mean_ns = best.moves > 0 ? best.total_move_ns / best.moves : 0;
+    std::cout << games.size() << " games, " << best.moves << " moves\n"
+              << "mean move:    " << mean_ns << " ns (max " << thresholds.max_mean_move_ns
+              << ")\n"
+              << "slowest move: " << best.max_move_ns << " ns (max " << thresholds.max_move_ns
+              << ")\n"
+              << "start allocs: " << best.max_start_allocs << " (max "
+              << thresholds.max_start_allocs << ")\n"
+              << "restart allocs: " << best.max_restart_allocs << " (max "
+              << thresholds.max_restart_allocs << ")\n"
+              << "move allocs:  " << best.max_move_allocs << " (max "
+              << thresholds.max_move_allocs << ")\n";
+
+    bool regression = mean_ns > thresholds.max_mean_move_ns ||
+                      best.max_move_ns > thresholds.max_move_ns ||
+                      best.max_start_allocs > thresholds.max_start_allocs ||
+                      best.max_restart_allocs > thresholds.max_restart_allocs ||
+                      best.max_move_allocs > thresholds.max_move_allocs;
+    if (regression) {
+        std::cerr << "performance regression\n";
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
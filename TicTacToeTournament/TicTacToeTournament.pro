@@ -0,0 +1,25 @@
+#-------------------------------------------------
+#
+# Engine tournament and rating tool for TicTacToeCore
+#
+#-------------------------------------------------
+
+QT       -= gui
+
+TARGET = TicTacToeTournament
+TEMPLATE = app
+CONFIG += c++17
+CONFIG += console thread
+CONFIG -= app_bundle
+
+DEFINES += QT_DEPRECATED_WARNINGS
+
+SOURCES += \
+        main.cpp
+
+win32:CONFIG(release, debug|release): LIBS += -L$$OUT_PWD/../TicTacToeCore/release/ -lTicTacToeCore
+else:win32:CONFIG(debug, debug|release): LIBS += -L$$OUT_PWD/../TicTacToeCore/debug/ -lTicTacToeCore
+else:unix: LIBS += -L$$OUT_PWD/../TicTacToeCore/ -lTicTacToeCore
+
+INCLUDEPATH += $$PWD/../TicTacToeCore
+DEPENDPATH += $$PWD/../TicTacToeCore
@@ -0,0 +1,522 @@
+/// @file
+///
+/// Plays engines against each other on all cores and rates them.
+///
+/// Every pairing plays every first move with both colors, round after round. Each round
+/// continues the first moves with new seeded openings, so that deterministic engines do not
+/// replay the same games; a pairing of deterministic engines stops once its openings are
+/// exhausted. The scores give Elo differences with 95% confidence intervals, and an optional
+/// SPRT stops the run as soon as each pairing is statistically decided.
+///
+/// Usage:
+///     TicTacToeTournament [options] <engine> <engine> [<engine>...]
+///         --gauntlet                 the first engine plays all the others (default: round robin)
+///         --rounds N                 rounds of all first moves and colors (default 10)
+///         --plies N                  opening plies, 1 to 4 (default 3)
+///         --threads N                worker threads (default: all cores)
+///         --sprt elo0 elo1 alpha beta   stop a pairing when H0 (elo0) or H1 (elo1) is accepted
+///         --config file              parameters of the configured engine
+///         --weights file             evaluator weights of the learned engine
+///
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+#include <tictactoe_game.hpp>
+
+namespace {
+
+using namespace tictactoe;
+
+///
+/// \brief The Engine struct, a registered computer player
+///
+struct Engine {
+    const char* name;
+    Difficulty difficulty;
+};
+
+///
+/// \brief Engines The policies, then the difficulty levels offered to the players
+///
+std::vector<Engine> Engines()
+{
+    std::vector<Engine> engines{
+        {"normal", PolicyKind::normal},
+        {"impossible", PolicyKind::impossible},
+        {"learned", PolicyKind::learned},
+        {"configured", PolicyKind::configured},
+    };
+    for (const auto& level : difficulty_levels) {
+        engines.push_back({level.name, level.difficulty});
+    }
+    return engines;
+}
+
+const std::vector<Engine> engines = Engines();
+
+const Engine* FindEngine(const std::string& name)
+{
+    auto it = std::find_if(engines.begin(), engines.end(),
+                           [&name](const Engine& e) { return name == e.name; });
+    return it != engines.end() ? &*it : nullptr;
+}
+
+constexpr uint8_t cell_count = board_size * board_size;
+
+/// Longest opening: one more ply and X could complete a line
+constexpr size_t max_opening_plies = 2 * (board_size - 1);
+
+///
+/// \brief Opening Cell indices of the first moves, X first
+///
+using Opening = std::vector<uint8_t>;
+
+///
+/// \brief The OpeningBook class, every opening of a given length
+///
+/// The openings starting with each first move are shuffled with a fixed seed. Round r plays the
+/// r-th of each, so the first rounds already spread over the book and every run (and platform)
+/// plays the same games.
+///
+class OpeningBook {
+public:
+    explicit OpeningBook(size_t plies)
+    {
+        for (uint8_t first = 0; first < cell_count; ++first) {
+            auto& openings = m_openings[first];
+            Opening opening{first};
+            Extend(opening, plies, openings);
+            // Own Fisher-Yates: std::shuffle differs between standard libraries
+            std::mt19937 rng{first + 1u};
+            for (size_t i = openings.size() - 1; i > 0; --i) {
+                std::swap(openings[i], openings[rng() % (i + 1)]);
+            }
+        }
+    }
+
+    /// Number of distinct openings per first move
+    size_t Rounds() const { return m_openings[0].size(); }
+
+    ///
+    /// \brief Get The opening of a round, repeated once the book is exhausted
+    /// \param round
+    /// \param first First move
+    /// \return
+    ///
+    const Opening& Get(size_t round, uint8_t first) const
+    {
+        return m_openings[first][round % Rounds()];
+    }
+
+private:
+    static void Extend(Opening& opening, size_t plies, std::vector<Opening>& openings)
+    {
+        if (opening.size() == plies) {
+            openings.push_back(opening);
+            return;
+        }
+        for (uint8_t cell = 0; cell < cell_count; ++cell) {
+            if (std::find(opening.begin(), opening.end(), cell) == opening.end()) {
+                opening.push_back(cell);
+                Extend(opening, plies, openings);
+                opening.pop_back();
+            }
+        }
+    }
+
+private:
+    std::array<std::vector<Opening>, cell_count> m_openings;
+};
+
+///
+/// \brief The Job struct, one game to play
+///
+struct Job {
+    size_t pairing;
+    const Opening* opening;
+    bool first_is_x;
+    uint32_t seed;
+};
+
+///
+/// \brief The Pairing struct, results from the first engine's point of view
+///
+struct Pairing {
+    size_t first;
+    size_t second;
+    size_t wins{0};
+    size_t draws{0};
+    size_t losses{0};
+    /// Both engines play without noise: an opening always gives the same game
+    bool deterministic{false};
+    bool decided{false};
+    const char* verdict{""};
+
+    size_t Games() const { return wins + draws + losses; }
+};
+
+///
+/// \brief The Stats struct, score and Elo estimate of a set of results
+///
+struct Stats {
+    double score;
+    double elo;
+    double elo_low;
+    double elo_high;
+    double variance;
+};
+
+double EloFromScore(double score)
+{
+    score = std::min(std::max(score, 1e-6), 1 - 1e-6);
+    return -400.0 * std::log10(1.0 / score - 1.0);
+}
+
+double ScoreFromElo(double elo)
+{
+    return 1.0 / (1.0 + std::pow(10.0, -elo / 400.0));
+}
+
+Stats ComputeStats(size_t wins, size_t draws, size_t losses)
+{
+    Stats stats{0.5, 0, 0, 0, 0};
+    double n = static_cast<double>(wins + draws + losses);
+    if (n == 0) {
+        return stats;
+    }
+    double w = wins / n, d = draws / n, l = losses / n;
+    stats.score = w + d / 2;
+    stats.variance = w * std::pow(1 - stats.score, 2) + d * std::pow(0.5 - stats.score, 2) +
+                     l * std::pow(0 - stats.score, 2);
+    double margin = 1.96 * std::sqrt(stats.variance / n);
+    stats.elo = EloFromScore(stats.score);
+    stats.elo_low = EloFromScore(stats.score - margin);
+    stats.elo_high = EloFromScore(stats.score + margin);
+    return stats;
+}
+
+///
+/// \brief The Sprt struct, sequential probability ratio test on the Elo difference
+///
+struct Sprt {
+    bool enabled{false};
+    double elo0{0};
+    double elo1{5};
+    double alpha{0.05};
+    double beta{0.05};
+
+    ///
+    /// \brief LogLikelihoodRatio Normal approximation of the trinomial GSPRT
+    ///
+    double LogLikelihoodRatio(const Pairing& p) const
+    {
+        auto stats = ComputeStats(p.wins, p.draws, p.losses);
+        double s0 = ScoreFromElo(elo0), s1 = ScoreFromElo(elo1);
+        double variance = std::max(stats.variance, 1e-6);
+        return p.Games() * (s1 - s0) * (2 * stats.score - s0 - s1) / (2 * variance);
+    }
+
+    double LowerBound() const { return std::log(beta / (1 - alpha)); }
+
+    double UpperBound() const { return std::log((1 - beta) / alpha); }
+};
+
+///
+/// \brief The Player class, one engine and the game it plays in
+///
+/// Each engine runs its own TicTacToeGame where it is the computer and the opponent's moves
+/// come in as human moves.
+///
+class Player {
+public:
+    Player()
+        : m_status{GameStatus::not_started}
+        , m_changed{0}
+        , m_callback{[this](const GameUpdate& update) {
+            m_status = update.status;
+            m_changed |= update.changed_cells;
+        }}
+    {
+        m_game.SetCoalesceUpdates(true);
+        m_game.SetCallback(m_callback);
+    }
+
+    ///
+    /// \brief Start
+    /// \param engine
+    /// \param side Side of this engine
+    /// \param opening First move when playing X
+    /// \param seed
+    /// \return The opening move, npos if this engine plays O
+    ///
+    uint8_t Start(const Engine& engine, PlayerSide side, uint8_t opening, uint32_t seed)
+    {
+        bool x = side == PlayerSide::xs;
+        m_game.Seed(seed);
+        m_game.SetOpening(opening % board_size, opening / board_size);
+        m_changed = 0;
+        m_game.Restart(x ? PlayerSide::os : PlayerSide::xs,
+                       x ? PlayerType::computer : PlayerType::human, engine.difficulty);
+        return x ? Reply(TicTacToeGame::npos) : TicTacToeGame::npos;
+    }
+
+    ///
+    /// \brief Play Pass the opponent's move and get the reply
+    /// \param move Cell index
+    /// \param forced Reply from the opening, npos to let the engine choose
+    /// \return The reply cell index, npos if the game is over
+    ///
+    uint8_t Play(uint8_t move, uint8_t forced)
+    {
+        m_changed = 0;
+        if (forced != TicTacToeGame::npos) {
+            m_game.SetNextMove(forced % board_size, forced / board_size);
+        }
+        m_game.HumanMove(move % board_size, move / board_size);
+        return Reply(move);
+    }
+
+    GameStatus Status() const { return m_status; }
+
+private:
+    uint8_t Reply(uint8_t ignored) const
+    {
+        for (uint8_t i = 0; i < board_size * board_size; ++i) {
+            if (i != ignored && (m_changed & (1u << i)) &&
+                m_game.GetCell(i % board_size, i / board_size).value != CellValue::None) {
+                return i;
+            }
+        }
+        return TicTacToeGame::npos;
+    }
+
+private:
+    TicTacToeGame m_game;
+    GameStatus m_status;
+    CellMask m_changed;
+    GameUpdateCalback m_callback;
+};
+
+///
+/// \brief PlayGame
+/// \return 1 if the X engine won, 0 for a draw, -1 if O won
+///
+int PlayGame(const Engine& x_engine, const Engine& o_engine, const Opening& opening,
+             uint32_t seed)
+{
+    Player x, o;
+    o.Start(o_engine, PlayerSide::os, opening[0], seed);
+    auto move = x.Start(x_engine, PlayerSide::xs, opening[0], seed);
+
+    bool o_to_play = true;
+    for (size_t ply = 1; move != TicTacToeGame::npos; ++ply) {
+        auto forced = ply < opening.size() ? opening[ply] : TicTacToeGame::npos;
+        move = o_to_play ? o.Play(move, forced) : x.Play(move, forced);
+        o_to_play = !o_to_play;
+    }
+
+    // Only the game of the engine that moved last saw the final move
+    auto status = o_to_play ? x.Status() : o.Status();
+    return status == GameStatus::xs_winner ? 1 : status == GameStatus::os_winner ? -1 : 0;
+}
+
+void PrintUsage(const char* program)
+{
+    std::cerr << "usage: " << program
+              << " [--gauntlet] [--rounds N] [--plies N] [--threads N]"
+                 " [--sprt elo0 elo1 alpha beta] [--config file] [--weights file]"
+                 " <engine> <engine> [<engine>...]\nengines:";
+    for (const auto& engine : engines) {
+        std::cerr << " " << engine.name;
+    }
+    std::cerr << "\n";
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    bool gauntlet = false;
+    size_t rounds = 10;
+    size_t plies = 3;
+    size_t threads = std::max(1u, std::thread::hardware_concurrency());
+    Sprt sprt;
+    std::vector<const Engine*> players;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--gauntlet") {
+            gauntlet = true;
+        }
+        else if (arg == "--rounds" && i + 1 < argc) {
+            rounds = std::strtoul(argv[++i], nullptr, 10);
+        }
+        else if (arg == "--plies" && i + 1 < argc) {
+            plies = std::min<size_t>(std::max(1ul, std::strtoul(argv[++i], nullptr, 10)),
+                                     max_opening_plies);
+        }
+        else if (arg == "--threads" && i + 1 < argc) {
+            threads = std::max(1ul, std::strtoul(argv[++i], nullptr, 10));
+        }
+        else if (arg == "--sprt" && i + 4 < argc) {
+            sprt.enabled = true;
+            sprt.elo0 = std::atof(argv[++i]);
+            sprt.elo1 = std::atof(argv[++i]);
+            sprt.alpha = std::atof(argv[++i]);
+            sprt.beta = std::atof(argv[++i]);
+        }
+        else if (arg == "--config" && i + 1 < argc) {
+            // Parameters of the configured engine
+            std::string error;
+            if (!PolicyConfig::Reload(argv[++i], &error)) {
+                std::cerr << error << "\n";
+                return EXIT_FAILURE;
+            }
+        }
+        else if (arg == "--weights" && i + 1 < argc) {
+            // Weights of the learned engine
+            if (!LearnedGamePolicy::LoadWeights(argv[++i])) {
+                std::cerr << "cannot load the weights " << argv[i] << "\n";
+                return EXIT_FAILURE;
+            }
+        }
+        else if (auto engine = FindEngine(arg)) {
+            players.push_back(engine);
+        }
+        else {
+            PrintUsage(argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+    if (players.size() < 2) {
+        PrintUsage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    std::vector<Pairing> pairings;
+    for (size_t a = 0; a < players.size(); ++a) {
+        for (size_t b = a + 1; b < players.size(); ++b) {
+            if (!gauntlet || a == 0) {
+                Pairing pairing{a, b};
+                pairing.deterministic = players[a]->difficulty.noise_percent == 0 &&
+                                        players[b]->difficulty.noise_percent == 0;
+                pairings.push_back(pairing);
+            }
+        }
+    }
+
+    // Round major, so that stopping early leaves every pairing with balanced colors/openings.
+    // Replaying an opening between deterministic engines would only repeat a game, and count
+    // it as a new sample.
+    const OpeningBook book{plies};
+    std::vector<Job> jobs;
+    uint32_t seed = 1;
+    bool exhausted = false;
+    for (size_t round = 0; round < rounds; ++round) {
+        for (uint8_t first = 0; first < cell_count; ++first) {
+            const auto& opening = book.Get(round, first);
+            for (size_t p = 0; p < pairings.size(); ++p) {
+                if (pairings[p].deterministic && round >= book.Rounds()) {
+                    exhausted = true;
+                    continue;
+                }
+                jobs.push_back({p, &opening, true, seed});
+                jobs.push_back({p, &opening, false, seed++});
+            }
+        }
+    }
+
+    const size_t cycle = 2 * cell_count;
+    std::mutex mutex;
+    std::atomic<size_t> next{0};
+    std::atomic<size_t> undecided{pairings.size()};
+    std::vector<std::thread> workers;
+    for (size_t t = 0; t < threads; ++t) {
+        workers.emplace_back([&] {
+            for (size_t i = next++; i < jobs.size() && undecided > 0; i = next++) {
+                const auto& job = jobs[i];
+                auto& pairing = pairings[job.pairing];
+                if (sprt.enabled) {
+                    // Skip the games of the decided pairings, flagged by other workers
+                    std::lock_guard<std::mutex> lock{mutex};
+                    if (pairing.decided) {
+                        continue;
+                    }
+                }
+                const auto& first = *players[pairing.first];
+                const auto& second = *players[pairing.second];
+                int result = job.first_is_x ? PlayGame(first, second, *job.opening, job.seed)
+                                            : -PlayGame(second, first, *job.opening, job.seed);
+
+                std::lock_guard<std::mutex> lock{mutex};
+                if (pairing.decided) {
+                    continue;
+                }
+                (result > 0 ? pairing.wins : result < 0 ? pairing.losses : pairing.draws)++;
+                // Decide on whole cycles of openings and colors only, the first ones are too
+                // few games to trust the variance estimate
+                if (sprt.enabled && pairing.Games() % cycle == 0) {
+                    double llr = sprt.LogLikelihoodRatio(pairing);
+                    if (llr >= sprt.UpperBound() || llr <= sprt.LowerBound()) {
+                        pairing.decided = true;
+                        pairing.verdict = llr >= sprt.UpperBound() ? "H1 accepted" : "H0 accepted";
+                        --undecided;
+                    }
+                }
+            }
+        });
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+
+    std::cout << std::fixed << std::setprecision(1);
+    std::cout << "pairing                        games    W    D    L     elo    95% interval\n";
+    for (const auto& p : pairings) {
+        auto stats = ComputeStats(p.wins, p.draws, p.losses);
+        std::string name = std::string{players[p.first]->name} + " vs " + players[p.second]->name;
+        std::cout << std::left << std::setw(30) << name << std::right << std::setw(6) << p.Games()
+                  << std::setw(5) << p.wins << std::setw(5) << p.draws << std::setw(5) << p.losses
+                  << std::setw(8) << stats.elo << "  [" << stats.elo_low << ", " << stats.elo_high
+                  << "]";
+        if (sprt.enabled) {
+            std::cout << "  LLR " << std::setprecision(2) << sprt.LogLikelihoodRatio(p) << " ("
+                      << sprt.LowerBound() << ", " << sprt.UpperBound() << ") "
+                      << (p.decided ? p.verdict : "undecided") << std::setprecision(1);
+        }
+        std::cout << "\n";
+    }
+    if (exhausted) {
+        std::cout << "pairings without noise stop after the " << book.Rounds()
+                  << " rounds of distinct " << plies << " ply openings\n";
+    }
+
+    // Overall rating of each engine against the field
+    std::cout << "\nengine          games   score     elo    95% interval\n";
+    for (size_t e = 0; e < players.size(); ++e) {
+        size_t wins = 0, draws = 0, losses = 0;
+        for (const auto& p : pairings) {
+            if (p.first == e || p.second == e) {
+                wins += (p.first == e) ? p.wins : p.losses;
+                losses += (p.first == e) ? p.losses : p.wins;
+                draws += p.draws;
+            }
+        }
+        auto stats = ComputeStats(wins, draws, losses);
+        std::cout << std::left << std::setw(14) << players[e]->name << std::right << std::setw(7)
+                  << wins + draws + losses << std::setw(8) << 100 * stats.score << "%"
+                  << std::setw(8) << stats.elo << "  [" << stats.elo_low << ", "
+                  << stats.elo_high << "]\n";
+    }
+    return EXIT_SUCCESS;
+}
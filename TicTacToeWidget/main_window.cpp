@@ -5,7 +5,8 @@
 MainWindow::MainWindow(QWidget* parent)
     : QMainWindow(parent)
     , ui(new Ui::MainWindow)
-    , m_callback{[this](tictactoe::GameStatus status) { GameUpdated(status); }}
+    , m_callback{[this](const tictactoe::GameUpdate& update) { GameUpdated(update); }}
+    , m_status{tictactoe::GameStatus::not_started}
 {
     ui->setupUi(this);
 
@@ -19,8 +20,16 @@ MainWindow::MainWindow(QWidget* parent)
     m_map[7] = ui->cell8;
     m_map[8] = ui->cell9;
 
+    for (const auto& level : tictactoe::difficulty_levels) {
+        ui->difficultyComboBox->addItem(level.name);
+    }
+    ui->difficultyComboBox->setCurrentIndex(static_cast<int>(tictactoe::default_difficulty));
+
+    // One repaint per human turn, covering both moves
+    m_game.SetCoalesceUpdates(true);
+
     m_game.Start(tictactoe::PlayerSide::xs, tictactoe::PlayerType::human, m_callback,
-                 ui->easyCheckBox->isChecked());
+                 SelectedDifficulty());
 }
 
 MainWindow::~MainWindow()
@@ -28,45 +37,36 @@ MainWindow::~MainWindow()
     delete ui;
 }
 
-void MainWindow::GameUpdated(tictactoe::GameStatus status)
+tictactoe::Difficulty MainWindow::SelectedDifficulty() const
+{
+    auto level = static_cast<size_t>(ui->difficultyComboBox->currentIndex());
+    return tictactoe::difficulty_levels[level].difficulty;
+}
+
+void MainWindow::GameUpdated(const tictactoe::GameUpdate& update)
 {
+    tictactoe::CellMask refresh = update.changed_cells;
+    // The end of the game disables the remaining cells and highlights the winning line
+    if (update.status != m_status) {
+        refresh = tictactoe::all_cells;
+    }
+
     for (uint8_t x = 0; x < tictactoe::board_size; ++x) {
         for (uint8_t y = 0; y < tictactoe::board_size; ++y) {
-            auto& cell = m_game.GetCell(x, y);
-            uint8_t id = y * tictactoe::board_size + x;
-            auto button = m_map[id];
-
-            switch (cell.value) {
-            case tictactoe::CellValue::O:
-                button->setText("O");
-                button->setEnabled(false);
-                button->setDown(true);
-                break;
-            case tictactoe::CellValue::X:
-                button->setText("X");
-                button->setEnabled(false);
-                button->setDown(true);
-                break;
-            default:
-                //button->setText(QString("%1 %2").arg(cell.attack_points).arg(cell.defense_points));
-                button->setText("");
-                button->setEnabled(status == tictactoe::GameStatus::in_progress);
-                button->setDown(status != tictactoe::GameStatus::in_progress);
-                break;
-            }
-            // Mark winning line
-            if (cell.attack_points == tictactoe::TicTacToeGame::npos) {
-                button->setStyleSheet("QPushButton{color:green;}");
-            }
-            else {
-                button->setStyleSheet("QPushButton{color:black;}");
+            if (refresh & tictactoe::CellBit(x, y)) {
+                UpdateButton(x, y, update);
             }
         }
     }
 
+    if (update.status == m_status) {
+        return;
+    }
+    m_status = update.status;
+
     QString str;
 
-    switch (status) {
+    switch (update.status) {
     case tictactoe::GameStatus::in_progress:
         str = "Game Started";
         break;
@@ -86,6 +86,39 @@ void MainWindow::GameUpdated(tictactoe::GameStatus status)
     ui->gameStatusLabel->setText(str);
 }
 
+void MainWindow::UpdateButton(uint8_t x, uint8_t y, const tictactoe::GameUpdate& update)
+{
+    auto& cell = m_game.GetCell(x, y);
+    uint8_t id = y * tictactoe::board_size + x;
+    auto button = m_map[id];
+
+    switch (cell.value) {
+    case tictactoe::CellValue::O:
+        button->setText("O");
+        button->setEnabled(false);
+        button->setDown(true);
+        break;
+    case tictactoe::CellValue::X:
+        button->setText("X");
+        button->setEnabled(false);
+        button->setDown(true);
+        break;
+    default:
+        //button->setText(QString("%1 %2").arg(cell.attack_points).arg(cell.defense_points));
+        button->setText("");
+        button->setEnabled(update.status == tictactoe::GameStatus::in_progress);
+        button->setDown(update.status != tictactoe::GameStatus::in_progress);
+        break;
+    }
+    // Mark winning line
+    if (update.winning_line & tictactoe::CellBit(x, y)) {
+        button->setStyleSheet("QPushButton{color:green;}");
+    }
+    else {
+        button->setStyleSheet("QPushButton{color:black;}");
+    }
+}
+
 void MainWindow::on_cell1_clicked()
 {
     m_game.HumanMove(0, 0);
@@ -133,12 +166,12 @@ void MainWindow::on_cell9_clicked()
 
 void MainWindow::on_restartButton_clicked()
 {
-    m_game.Start(tictactoe::PlayerSide::xs, tictactoe::PlayerType::human, m_callback,
-                 ui->easyCheckBox->isChecked());
+    m_game.Restart(tictactoe::PlayerSide::xs, tictactoe::PlayerType::human,
+                   SelectedDifficulty());
 }
 
 void MainWindow::on_computerStart_clicked()
 {
-    m_game.Start(tictactoe::PlayerSide::os, tictactoe::PlayerType::computer, m_callback,
-                 ui->easyCheckBox->isChecked());
+    m_game.Restart(tictactoe::PlayerSide::os, tictactoe::PlayerType::computer,
+                   SelectedDifficulty());
 }
@@ -18,7 +18,9 @@ public:
     ~MainWindow();
 
 private:
-    void GameUpdated(tictactoe::GameStatus status);
+    tictactoe::Difficulty SelectedDifficulty() const;
+    void GameUpdated(const tictactoe::GameUpdate& update);
+    void UpdateButton(uint8_t x, uint8_t y, const tictactoe::GameUpdate& update);
 
 private slots:
     void on_cell1_clicked();
@@ -36,6 +38,7 @@ private slots:
 private:
     Ui::MainWindow* ui;
     tictactoe::GameUpdateCalback m_callback;
+    tictactoe::GameStatus m_status;
     tictactoe::TicTacToeGame m_game;
     std::map<uint8_t, QPushButton*> m_map;
 };